@@ -1,12 +1,18 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
+#include <queue>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
+#include "day_1_simd.hpp"
 
 #define DAY 1
 
+#define USE_TASK_POOL true // big inputs are cut at newlines into a piece per thread, scanned on the work-stealing pool.
+
 NAMESPACE_DEF(DAY) {
 
 /**
@@ -31,96 +37,89 @@ struct AutomatonConfig {
     int input_accepted_value;
 };
 
-class AutomatonInterface {
-protected:
-    explicit AutomatonInterface(std::function<void(int)> cb) : input_accept_callback(std::move(cb)) {}
-    AutomatonInterface() : AutomatonInterface([](int){}) {}
-
-public:
-    virtual void feed(char c) = 0;
-    virtual ~AutomatonInterface() = default;
-
-    std::function<void(int)> input_accept_callback;
-};
-
-class Automaton : public AutomatonInterface {
-
-    const char * language;
-    const int input_accept_value;
-
-    int language_index = 0;
-
+/**
+ * Every AutomatonConfig compiled into one Aho-Corasick DFA. The goto and failure links are folded into a full transition table,
+ * so feeding a byte is one lookup and there is no backtracking. (This used to be a tree of Automaton objects with a
+ * std::function callback each, and every byte went through a virtual feed() per automaton.)
+ * Bytes that appear in none of the languages all share one column of the table.
+ */
+class AutomatonTable {
 public:
-    Automaton(AutomatonConfig config, std::function<void(int)> callback)
-            : AutomatonInterface(std::move(callback))
-            , language(config.language)
-            , input_accept_value(config.input_accepted_value)
-    { }
-
-    explicit Automaton(AutomatonConfig&& config) : Automaton(config, [](int){}) {}
-
-    void feed(char c) override {
-        bool matching = c == language[language_index];
-
-        if (! matching) {
-            language_index = 0;
-            // Don't give up yet, we fall back to index 0, but maybe index 0 is a match?
-            // If you do not do this, things like "eeight" for "eight" will be missed.
-            language_index += (c == language[0]);
-        } else {
-            language_index += 1;
-            if ('\0' == language[language_index]) {
-                language_index = 0;
-                input_accept_callback(input_accept_value);
+    static constexpr int REJECT = std::numeric_limits<int>::min();
+
+    explicit AutomatonTable(const std::vector<AutomatonConfig>& blueprints) {
+        byte_class.fill(0);
+        for (const auto& b : blueprints) {
+            for (const char * c = b.language; *c != '\0'; ++c) {
+                auto& cls = byte_class[static_cast<uint8_t>(*c)];
+                if (cls == 0) cls = ++class_count;
             }
         }
-    }
-};
-
-class MultiAutomaton : public AutomatonInterface {
-    std::vector<std::unique_ptr<AutomatonInterface>> automata;
-
-public:
-    explicit MultiAutomaton(std::vector<AutomatonConfig> && blueprints) {
-        for (auto&& b : blueprints) {
+        ++class_count; // class 0, the rest of the bytes.
+
+        // The trie. Missing edges are EMPTY for now.
+        constexpr uint16_t EMPTY = std::numeric_limits<uint16_t>::max();
+        addState(EMPTY);
+        for (const auto& b : blueprints) {
+            uint16_t state = 0;
+            for (const char * c = b.language; *c != '\0'; ++c) {
+                size_t edge = state * class_count + byte_class[static_cast<uint8_t>(*c)];
+                if (transitions[edge] == EMPTY) {
+                    uint16_t added = addState(EMPTY); // resizes 'transitions', so no references into it over this.
+                    transitions[edge] = added;
+                }
+                state = transitions[edge];
+            }
+            accept[state] = b.input_accepted_value;
+        }
 
-            auto a = std::make_unique<Automaton>(std::forward<AutomatonConfig>(b), [this](int x) {
-                this->input_accept_callback(x);
-            });
-            automata.emplace_back(std::move(a));
+        // Breadth first, so the failure state of every state is done before the state itself.
+        std::vector<uint16_t> failure(accept.size(), 0);
+        std::queue<uint16_t> bfs;
+        bfs.push(0);
+        while (! bfs.empty()) {
+            uint16_t state = bfs.front();
+            bfs.pop();
+            for (int cls = 0; cls < class_count; ++cls) {
+                uint16_t& next = transitions[state * class_count + cls];
+                uint16_t fallback = state == 0 ? 0 : transitions[failure[state] * class_count + cls];
+                if (next == EMPTY) {
+                    next = fallback;
+                } else {
+                    failure[next] = fallback;
+                    // A language that ends in a suffix of this state is accepted here too. The longest one wins.
+                    if (accept[next] == REJECT) accept[next] = accept[fallback];
+                    bfs.push(next);
+                }
+            }
         }
     }
 
-    MultiAutomaton(MultiAutomaton && other) noexcept
-            : AutomatonInterface(other.input_accept_callback)
-            , automata(std::move(other.automata))
-    {
-        // Bad news, the bound [this] on the assigned callbacks is undefined behavior to use after the move.
-        // And I don't think I can just tell the function closure to "update the fucking pointer to something else",
-        // So... I'm just throwing away whatever callbacks were in there, and making new ones.
-        // This kills composition of nested MultiAutomatons.
-        for (auto& a : automata) {
-            a->input_accept_callback = [this](int x) {
-                this->input_accept_callback(x);
-            };
+    // Calls onAccept(value) every time one of the languages is matched, like the callbacks of the old automata did.
+    template<typename F>
+    void feed(std::string_view input, F&& onAccept) const {
+        uint16_t state = 0;
+        for (char c : input) {
+            state = transitions[state * class_count + byte_class[static_cast<uint8_t>(c)]];
+            if (accept[state] != REJECT) onAccept(accept[state]);
         }
     }
 
-    MultiAutomaton() = default;
-
-    void add(std::unique_ptr<AutomatonInterface> other) {
-
-        other->input_accept_callback = [original_cb = other->input_accept_callback, this](int x){
-            original_cb(x);
-            this->input_accept_callback(x);
-        };
-        automata.emplace_back(std::move(other));
-    }
+    [[nodiscard]] size_t stateCount() const { return accept.size(); }
 
-    void feed(char c) override {
-        for (auto& a : automata) {
-            a->feed(c);
+private:
+    std::array<uint8_t, 256> byte_class{};
+    int class_count = 0;
+    std::vector<uint16_t> transitions; // state * class_count + byte class.
+    std::vector<int> accept;
+
+    uint16_t addState(uint16_t fill) {
+        if (accept.size() >= std::numeric_limits<uint16_t>::max()) {
+            throw std::logic_error("Too many states for an AutomatonTable");
         }
+        accept.push_back(REJECT);
+        transitions.resize(transitions.size() + class_count, fill);
+        return static_cast<uint16_t>(accept.size() - 1);
     }
 };
 
@@ -128,13 +127,17 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+    void parse(std::istream& input) override {
         std::ostringstream s;
         s << input.rdbuf();
         entire_input_string = s.str();
     }
 
+#define SIMD_SCANNER true // whole buffer, 32 bytes at a time. See day_1_simd.hpp.
     void v1() const override {
+#if SIMD_SCANNER == true
+        reportSolution(sumLines(false));
+#else
         std::istringstream text(entire_input_string);
         int sum = 0;
         int first_in_line = 0;
@@ -172,34 +175,29 @@ public:
         }
 
         reportSolution(sum);
+#endif
     }
 
-#define SINGLE_PASS_AUTOMATA_SOLUTION false
+#define SINGLE_PASS_AUTOMATA_SOLUTION true
     void v2() const override {
-        std::istringstream text(entire_input_string);
-#if SINGLE_PASS_AUTOMATA_SOLUTION == true
+#if SIMD_SCANNER == true
+        reportSolution(sumLines(true));
+#elif SINGLE_PASS_AUTOMATA_SOLUTION == true
         const int NEWLINE_VALUE = -1;
-        MultiAutomaton digits({
+        static const AutomatonTable dfa({
             {"1", 1}, {"2", 2}, {"3", 3},
             {"4", 4}, {"5", 5}, {"6", 6},
-            {"7", 7}, {"8", 8}, {"9", 9}
-        });
-        MultiAutomaton sequences({
+            {"7", 7}, {"8", 8}, {"9", 9},
             {"one", 1},     {"two", 2},     {"three", 3},
             {"four", 4},    {"five", 5},    {"six", 6},
-            {"seven", 7},   {"eight", 8},   {"nine", 9}
+            {"seven", 7},   {"eight", 8},   {"nine", 9},
+            {"\n", NEWLINE_VALUE}
         });
-        Automaton newline({"\n", NEWLINE_VALUE});
-
-        MultiAutomaton nfa;
-        nfa.add(std::move(std::make_unique<MultiAutomaton>(std::move(digits))));
-        nfa.add(std::move(std::make_unique<MultiAutomaton>(std::move(sequences))));
-        nfa.add(std::move(std::make_unique<Automaton>(std::move(newline))));
 
         int line_first = 0;
         int line_last = 0;
         int sum = 0;
-        nfa.input_accept_callback = [&](int x) {
+        auto onAccept = [&](int x) {
             if (x == NEWLINE_VALUE) {
                 sum += line_first * 10 + line_last;
                 line_first = 0;
@@ -210,14 +208,12 @@ public:
             }
         };
 
-        int c;
-        while ((c = text.get()) != EOF) {
-            nfa.feed(static_cast<char>(c));
-        }
-        nfa.feed('\n'); // let's emulate EOF as a newline char, this flushes the last line to sum.
+        dfa.feed(entire_input_string, onAccept);
+        dfa.feed("\n", onAccept); // let's emulate EOF as a newline char, this flushes the last line to sum.
 
         reportSolution(sum);
 #else
+        std::istringstream text(entire_input_string);
         std::string line;
         int sum = 0;
 
@@ -240,9 +236,25 @@ public:
         entire_input_string.clear();
     }
 
+    [[nodiscard]] size_t throughputBytes() const override { return entire_input_string.size(); }
+
 private:
     std::string entire_input_string;
 
+    // Below this a piece is not worth waking up a thread for. The puzzle input is a single piece.
+    static constexpr size_t MIN_PIECE = 1 << 20;
+
+    int64_t sumLines(bool words) const {
+#if USE_TASK_POOL
+        auto pieces = Simd::splitAtNewlines(entire_input_string, TaskPool::global().threadCount(), MIN_PIECE);
+        return parallelReduce(0, static_cast<int64_t>(pieces.size()), int64_t{0}, [&](int64_t i) {
+            return Simd::scan(pieces[i], words);
+        }, std::plus<>{}, 1);
+#else
+        return Simd::scan(entire_input_string, words);
+#endif
+    }
+
 
     int get_char_of_line_fwd(const std::string& line) const {
 #define S std::string
@@ -383,4 +395,5 @@ private:
 
 }
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
\ No newline at end of file
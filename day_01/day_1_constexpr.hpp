@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 1, for the embedded input mode. Same answers as Day1, computed from a string_view.
+ */
+namespace Day1::Constexpr {
+
+constexpr std::array<std::string_view, 9> WORDS { "one", "two", "three", "four", "five", "six", "seven", "eight", "nine" };
+
+// The value of the digit (or spelled out digit) starting at line[i], -1 if there is none.
+constexpr int digitAt(std::string_view line, size_t i, bool words) {
+    if (ConstexprInput::isDigit(line[i])) return line[i] - '0';
+    if (! words) return -1;
+
+    auto rest = line.substr(i);
+    for (size_t w = 0; w < WORDS.size(); ++w) {
+        if (rest.starts_with(WORDS[w])) return static_cast<int>(w + 1);
+    }
+    return -1;
+}
+
+constexpr int64_t solve(std::string_view input, bool words) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (line.empty()) continue;
+
+        int first = -1;
+        for (size_t i = 0; i < line.size() && first < 0; ++i) {
+            first = digitAt(line, i, words);
+        }
+        int last = -1;
+        for (size_t i = line.size(); i > 0 && last < 0; --i) {
+            last = digitAt(line, i - 1, words);
+        }
+
+        sum += 10 * first + last;
+    }
+    return sum;
+}
+
+constexpr int64_t v1(std::string_view input) { return solve(input, false); }
+constexpr int64_t v2(std::string_view input) { return solve(input, true); }
+
+} // namespace
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../util/Cpu.hpp"
+#include "day_1_constexpr.hpp"
+
+/**
+ * Vectorised day 1. The input is never split into lines: every 32 byte block is classified in one go into
+ *  - a value per byte: the digit (or spelled out digit) that starts at that byte, 0 if none.
+ *  - a bitmask of bytes that have a value, and a bitmask of newlines.
+ * The first and last digit of a line are then just the lowest and highest set bit of the hits between two newlines.
+ * Words are matched by comparing the block against the block shifted by 1..4 bytes, so overlaps like "eightwo" find both.
+ *
+ * The puzzle has no zeroes, so a value of 0 doubles as "nothing here", which is also what the original v1 did.
+ */
+namespace Day1::Simd {
+
+constexpr size_t BLOCK = 32;
+constexpr size_t LOOKAHEAD = 4; // "three", "seven" and "eight" need 4 more bytes after their first.
+
+struct Block {
+    uint32_t hits;
+    uint32_t newlines;
+    alignas(BLOCK) std::array<uint8_t, BLOCK> values;
+};
+
+// Carries the unfinished line over block boundaries.
+struct LineSum {
+    int64_t sum = 0;
+    int first = 0;
+    int last = 0;
+
+    void take(uint32_t hits, const Block& b) {
+        if (hits == 0) return;
+        if (first == 0) first = b.values[__builtin_ctz(hits)];
+        last = b.values[31 - __builtin_clz(hits)];
+    }
+
+    void consume(const Block& b) {
+        uint32_t hits = b.hits;
+        uint32_t newlines = b.newlines;
+        while (newlines != 0) {
+            uint32_t nl = newlines & -newlines;
+            take(hits & (nl - 1), b);
+            sum += 10 * first + last;
+            first = 0;
+            last = 0;
+            hits &= ~((nl << 1) - 1); // for the top bit, nl << 1 is 0 and this clears everything. As it should.
+            newlines &= newlines - 1;
+        }
+        take(hits, b);
+    }
+
+    int64_t finish() const { return sum + 10 * first + last; } // the last line may not end in a newline.
+};
+
+// Reference classification, one byte at a time. Used when AVX2 is not around.
+// 'input' is the whole buffer, so words can be looked up past the end of the block.
+inline void classifyScalar(std::string_view input, size_t offset, bool words, Block& out) {
+    out.hits = 0;
+    out.newlines = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        int value = 0;
+        if (offset + i < input.size()) {
+            value = std::max(0, Constexpr::digitAt(input, offset + i, words));
+            out.newlines |= static_cast<uint32_t>(input[offset + i] == '\n') << i;
+        }
+        out.values[i] = value;
+        out.hits |= static_cast<uint32_t>(value != 0) << i;
+    }
+}
+
+#if AOC_X86 == true
+// All bytes where WORDS[W] starts. Expanded at compile time, GCC would rather keep a loop over the letters and broadcast them every block.
+template<size_t W, size_t... K>
+__attribute__((target("avx2"))) inline __m256i matchWord(const __m256i * shifted, std::index_sequence<K...>) {
+    __m256i match = _mm256_set1_epi8(-1);
+    ((match = _mm256_and_si256(match, _mm256_cmpeq_epi8(shifted[K], _mm256_set1_epi8(Constexpr::WORDS[W][K])))), ...);
+    return match;
+}
+
+// No two words share their first two letters, so at most one of them matches at any byte, and OR is enough to merge.
+template<size_t... W>
+__attribute__((target("avx2"))) inline __m256i matchWords(const __m256i * shifted, __m256i values, std::index_sequence<W...>) {
+    ((values = _mm256_or_si256(values, _mm256_and_si256(
+        matchWord<W>(shifted, std::make_index_sequence<Constexpr::WORDS[W].size()>{}),
+        _mm256_set1_epi8(static_cast<char>(W + 1))
+    ))), ...);
+    return values;
+}
+
+// 'p' must be readable for BLOCK + LOOKAHEAD bytes.
+template<bool Words>
+__attribute__((target("avx2"))) inline void classifyAvx2(const char * p, Block& out) {
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+
+    // '1' to '9'. Bytes above 127 are negative as signed chars, those fail the first comparison.
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(b, _mm256_set1_epi8('0')), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), b));
+    __m256i values = _mm256_and_si256(digit, _mm256_sub_epi8(b, _mm256_set1_epi8('0')));
+
+    if constexpr (Words) {
+        __m256i shifted[LOOKAHEAD + 1]; // not std::array, that drops the vector alignment attributes.
+        shifted[0] = b;
+        for (size_t k = 1; k <= LOOKAHEAD; ++k) {
+            shifted[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + k));
+        }
+        values = matchWords(shifted, values, std::make_index_sequence<Constexpr::WORDS.size()>{});
+    }
+
+    _mm256_store_si256(reinterpret_cast<__m256i*>(out.values.data()), values);
+    out.hits = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(values, _mm256_setzero_si256())));
+    out.newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('\n'))));
+}
+
+template<bool Words>
+__attribute__((target("avx2"))) inline int64_t scanAvx2(std::string_view input) {
+    LineSum lines;
+    Block block;
+
+    size_t offset = 0;
+    for (; offset + BLOCK + LOOKAHEAD <= input.size(); offset += BLOCK) {
+        classifyAvx2<Words>(input.data() + offset, block);
+        lines.consume(block);
+    }
+
+    // The tail is copied somewhere with enough zeroes behind it to do the lookahead. Zeroes never match anything.
+    std::array<char, 2 * BLOCK + LOOKAHEAD> tail{};
+    size_t remaining = input.size() - offset;
+    std::memcpy(tail.data(), input.data() + offset, remaining);
+    for (size_t t = 0; t < remaining; t += BLOCK) {
+        classifyAvx2<Words>(tail.data() + t, block);
+        lines.consume(block);
+    }
+
+    return lines.finish();
+}
+#endif
+
+inline int64_t scanScalar(std::string_view input, bool words) {
+    LineSum lines;
+    Block block;
+    for (size_t offset = 0; offset < input.size(); offset += BLOCK) {
+        classifyScalar(input, offset, words, block);
+        lines.consume(block);
+    }
+    return lines.finish();
+}
+
+// Cuts the input into at most 'parts' pieces that each end right after a newline, so every piece can be scanned on its own.
+// Words can not contain a newline, so nothing is lost at the cuts. Pieces are not made smaller than 'minPiece' bytes.
+inline std::vector<std::string_view> splitAtNewlines(std::string_view input, size_t parts, size_t minPiece) {
+    parts = std::clamp<size_t>(input.size() / std::max<size_t>(minPiece, 1), 1, std::max<size_t>(parts, 1));
+
+    std::vector<std::string_view> pieces;
+    size_t begin = 0;
+    for (size_t k = 1; k < parts; ++k) {
+        size_t target = std::max(begin, k * input.size() / parts);
+        size_t newline = input.find('\n', target);
+        if (newline == std::string_view::npos) break;
+        pieces.push_back(input.substr(begin, newline + 1 - begin));
+        begin = newline + 1;
+    }
+    if (begin < input.size() || pieces.empty()) pieces.push_back(input.substr(begin));
+    return pieces;
+}
+
+inline int64_t scan(std::string_view input, bool words) {
+#if AOC_X86 == true
+    if (Cpu::haveAvx2()) {
+        return words ? scanAvx2<true>(input) : scanAvx2<false>(input);
+    }
+#endif
+    return scanScalar(input, words);
+}
+
+} // namespace
+
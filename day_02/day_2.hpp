@@ -1,7 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <numeric>
+#include <string_view>
 
+#include "../util/Cpu.hpp"
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
 
@@ -11,12 +14,13 @@ NAMESPACE_DEF(DAY) {
 
 /**
  * Retroactively added to this template, used to be a lone int main() file.
- * The original consumed the ifstream directly, which is hard to replicate with immutability.
- * To do this, we parse the input into one big string, and use a stringstream on it in the solvers.
+ * The games are parsed once, straight off the stream, into a struct-of-arrays with the highest count of each colour per game.
+ * v1 and v2 are then a pass over three contiguous int16 arrays, 16 games at a time when AVX2 is around.
+ * (The original re-tokenised every line in both solvers, see original_solution_day_2.cpp.)
  */
 
 struct GameConstraints {
-    int16_t red, green, blue;
+    int16_t red = 0, green = 0, blue = 0;
 
     [[nodiscard]] int power() const { return red * green * blue; }
     void updateMin(const GameConstraints& other) {
@@ -30,159 +34,213 @@ bool operator>(const GameConstraints& a, const GameConstraints& b) {
     return a.red > b.red || a.green > b.green || a.blue > b.blue;
 }
 
-CLASS_DEF(DAY) {
-public:
-    DEFAULT_CTOR_DEF(DAY)
+// GameConstraints of every game, one array per colour. Game ids are the index + 1.
+// The arrays are padded with zeroes to a multiple of LANES, so the kernels need no tail loop.
+struct GameTable {
+    static constexpr size_t LANES = 16; // int16 in an AVX2 register.
 
-    void parse(std::ifstream& input) override {
-        std::ostringstream s;
-        s << input.rdbuf();
-        entire_input_string = s.str();
+    std::vector<int16_t> red, green, blue;
+    size_t count = 0;
+
+    void add(const GameConstraints& g) {
+        red.push_back(g.red);
+        green.push_back(g.green);
+        blue.push_back(g.blue);
+        ++count;
     }
 
-    void v1() const override {
-        std::istringstream text(entire_input_string);
+    void pad() {
+        size_t padded = (count + LANES - 1) / LANES * LANES;
+        red.resize(padded, 0);
+        green.resize(padded, 0);
+        blue.resize(padded, 0);
+    }
 
-        int game_id = 1;
-        int game_id_sum = 0;
+    void clear() {
+        red.clear();
+        green.clear();
+        blue.clear();
+        count = 0;
+    }
+};
 
-        std::string game;
-        while (std::getline(text, game)) {
-            bool legal_game = true;
-            size_t game_start_index = game.find(':');
-            while (game_start_index != std::string::npos) {
-                size_t game_end_index = std::min(game.size(), game.find(';', game_start_index + 1));
+namespace Kernels {
 
-                legal_game &= checkGameRound(game_start_index, game_end_index, game);
+// Sum of the ids of the games that never go over 'limit'.
+inline int64_t possibleIdSumScalar(const GameTable& t, GameConstraints limit) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < t.count; ++i) {
+        bool possible = t.red[i] <= limit.red && t.green[i] <= limit.green && t.blue[i] <= limit.blue;
+        sum += possible * static_cast<int64_t>(i + 1);
+    }
+    return sum;
+}
 
-                game_start_index = game.find(';', game_start_index + 1);
-            }
-            game_id_sum += legal_game * game_id;
-            game_id++;
-        }
+inline int64_t powerSumScalar(const GameTable& t) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < t.count; ++i) {
+        sum += t.red[i] * t.green[i] * t.blue[i];
+    }
+    return sum;
+}
 
-        reportSolution(game_id_sum);
+#if AOC_X86 == true
+__attribute__((target("avx2"))) inline int64_t possibleIdSumAvx2(const GameTable& t, GameConstraints limit) {
+    const __m256i limitRed = _mm256_set1_epi16(limit.red);
+    const __m256i limitGreen = _mm256_set1_epi16(limit.green);
+    const __m256i limitBlue = _mm256_set1_epi16(limit.blue);
+    const __m256i laneIndex = _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i laneId = _mm256_add_epi16(laneIndex, _mm256_set1_epi16(1));
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    // The id of game i + lane is i + lane + 1. The 'i' part is added per block as i * (possible games),
+    // the 'lane + 1' part stays in int32 lanes until the end. So ids never have to fit an int16.
+    __m256i laneIdSums = _mm256_setzero_si256();
+    int64_t blockSum = 0;
+    for (size_t i = 0; i < t.red.size(); i += GameTable::LANES) {
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t.red.data() + i));
+        __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t.green.data() + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t.blue.data() + i));
+
+        __m256i over = _mm256_or_si256(_mm256_cmpgt_epi16(r, limitRed), _mm256_or_si256(_mm256_cmpgt_epi16(g, limitGreen), _mm256_cmpgt_epi16(b, limitBlue)));
+        auto valid = static_cast<int16_t>(std::min<size_t>(t.count - i, GameTable::LANES)); // padding is not a game.
+        __m256i possible = _mm256_andnot_si256(over, _mm256_cmpgt_epi16(_mm256_set1_epi16(valid), laneIndex));
+
+        int possibleCount = __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(possible))) / 2; // 2 bytes per lane.
+        blockSum += static_cast<int64_t>(i) * possibleCount;
+        laneIdSums = _mm256_add_epi32(laneIdSums, _mm256_madd_epi16(_mm256_and_si256(possible, laneId), ones));
     }
 
-    void v2() const override {
-        std::istringstream text(entire_input_string);
-        std::string game;
-        int powerSum = 0;
-        while (std::getline(text, game)) {
-            size_t game_start_index = game.find(':');
-            GameConstraints minima = {0};
-            while (game_start_index != std::string::npos) {
-                size_t game_end_index = std::min(game.size(), game.find(';', game_start_index + 1));
-
-                updateMinima(game_start_index, game_end_index, game, minima);
-
-                game_start_index = game.find(';', game_start_index + 1);
-            }
+    alignas(32) std::array<int32_t, 8> lanes;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), laneIdSums);
+    return blockSum + std::accumulate(lanes.begin(), lanes.end(), int64_t{0});
+}
 
-            powerSum += minima.power();
-        }
+// r * g * b of 8 games, added up pairwise into 4 int64 lanes.
+// a product of three int16 does not fit in an int16, so the colours are widened to int32 first.
+__attribute__((target("avx2"))) inline __m256i power8Avx2(const int16_t * r, const int16_t * g, const int16_t * b) {
+    __m256i r32 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r)));
+    __m256i g32 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(g)));
+    __m256i b32 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+    __m256i p = _mm256_mullo_epi32(_mm256_mullo_epi32(r32, g32), b32);
+    return _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(p)), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1)));
+}
 
-        reportSolution(powerSum);
+__attribute__((target("avx2"))) inline int64_t powerSumAvx2(const GameTable& t) {
+    __m256i sums = _mm256_setzero_si256();
+    for (size_t i = 0; i < t.red.size(); i += GameTable::LANES) {
+        sums = _mm256_add_epi64(sums, power8Avx2(t.red.data() + i, t.green.data() + i, t.blue.data() + i));
+        sums = _mm256_add_epi64(sums, power8Avx2(t.red.data() + i + 8, t.green.data() + i + 8, t.blue.data() + i + 8));
     }
 
-    void parseBenchReset() override {
-        entire_input_string.clear(); // should be redundant since the string is assigned to in parse.
-    }
+    alignas(32) std::array<int64_t, 4> lanes;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), sums);
+    return std::accumulate(lanes.begin(), lanes.end(), int64_t{0});
+}
+#endif
 
-private:
-    std::string entire_input_string;
-    GameConstraints CONSTRAINTS = GameConstraints { 12, 13, 14 };
+inline int64_t possibleIdSum(const GameTable& t, GameConstraints limit) {
+#if AOC_X86 == true
+    if (Cpu::haveAvx2()) return possibleIdSumAvx2(t, limit);
+#endif
+    return possibleIdSumScalar(t, limit);
+}
+
+inline int64_t powerSum(const GameTable& t) {
+#if AOC_X86 == true
+    if (Cpu::haveAvx2()) return powerSumAvx2(t);
+#endif
+    return powerSumScalar(t);
+}
+
+} // namespace Kernels
 
-    static void updateMinima(size_t start, size_t end, const std::string &game, GameConstraints &minima) {
-        GameConstraints observed {0};
+CLASS_DEF(DAY) {
+public:
+    DEFAULT_CTOR_DEF(DAY)
+
+    // One pass over the stream, a chunk on the stack at a time. No lines or tokens are ever copied out.
+    void parse(std::istream& input) override {
+        GameConstraints game {};
+        GameConstraints round {};
         int16_t accumulator = 0;
-        for (size_t i = start; i < end; ++i) {
-            char read = game[i];
-            switch (read) {
-                // r, g, b was read: Store accumulator in the right constraint of this round.
-                // The accumulator should also be reset, for the next number read.
-                // but also because 'GReen' would add non-zero to red if you don't immediately.
-                case 'r':
-                    observed.red = static_cast<int16_t>(observed.red + accumulator);
-                    accumulator = 0;
-                    break;
-                case 'b':
-                    observed.blue = static_cast<int16_t>(observed.blue + accumulator);
-                    accumulator = 0;
-                    break;
-                case 'g':
-                    observed.green = static_cast<int16_t>(observed.green + accumulator);
-                    accumulator = 0;
-                    break;
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                    accumulator *= 10; // shift existing digits
-                    accumulator = static_cast<int16_t>(accumulator + (read - '0')); // add new one.
-                    break;
-                default: break;
+        bool inGame = false; // the last line may not end in a newline, then it still needs to be added.
+
+        std::array<char, 4096> chunk; // istreambuf_iterator is a call per char, which made this slower than getline was.
+        std::streamsize n;
+        while ((n = input.rdbuf()->sgetn(chunk.data(), chunk.size())) > 0) {
+            for (char read : std::string_view(chunk.data(), n)) {
+                switch (read) {
+                    // r, g, b was read: Store accumulator in the right constraint of this round.
+                    // The accumulator should also be reset, for the next number read.
+                    // but also because 'GReen' would add non-zero to red if you don't immediately.
+                    case 'r':
+                        round.red = static_cast<int16_t>(round.red + accumulator);
+                        accumulator = 0;
+                        break;
+                    case 'b':
+                        round.blue = static_cast<int16_t>(round.blue + accumulator);
+                        accumulator = 0;
+                        break;
+                    case 'g':
+                        round.green = static_cast<int16_t>(round.green + accumulator);
+                        accumulator = 0;
+                        break;
+                    case '0':
+                    case '1':
+                    case '2':
+                    case '3':
+                    case '4':
+                    case '5':
+                    case '6':
+                    case '7':
+                    case '8':
+                    case '9':
+                        accumulator *= 10; // shift existing digits
+                        accumulator = static_cast<int16_t>(accumulator + (read - '0')); // add new one.
+                        break;
+                    case ':': // that was the game id, it is implied by the order.
+                        accumulator = 0;
+                        inGame = true;
+                        break;
+                    case ';':
+                        game.updateMin(round);
+                        round = {};
+                        break;
+                    case '\n':
+                        if (inGame) finishGame(game, round);
+                        inGame = false;
+                        break;
+                    default: break;
+                }
             }
         }
+        if (inGame) finishGame(game, round);
+
+        games.pad();
+    }
 
-        // update minima:
-        minima.updateMin(observed);
+    void v1() const override {
+        reportSolution(Kernels::possibleIdSum(games, CONSTRAINTS));
     }
 
-    /**
-     * Given a start and end index, seeks the game string to read red & green & blue values.
-     * It accumulates these values and compares it against the global constraints.
-     * @param start start index of search space
-     * @param end end index of search spage
-     * @param game string to seek.
-     * @return whether the game was possible according to the global constraints variable.
-     */
-    bool checkGameRound(size_t start, size_t end, const std::string& game) const {
-        GameConstraints g = {0};
+    void v2() const override {
+        reportSolution(Kernels::powerSum(games));
+    }
 
-        int16_t accumulator = 0;
-        for (size_t i = start; i < end; ++i) {
-            char read = game[i];
-            switch (read) {
-                // r, g, b was read: Store accumulator in the right constraint of this round.
-                // The accumulator should also be reset, for the next number read.
-                // but also because 'GReen' would add non-zero to red if you don't immediately.
-                case 'r':
-                    g.red = static_cast<int16_t>(g.red + accumulator);
-                    accumulator = 0;
-                    break;
-                case 'b':
-                    g.blue = static_cast<int16_t>(g.blue + accumulator);
-                    accumulator = 0;
-                    break;
-                case 'g':
-                    g.green = static_cast<int16_t>(g.green + accumulator);
-                    accumulator = 0;
-                    break;
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                    accumulator *= 10; // shift existing digits
-                    accumulator = static_cast<int16_t>(accumulator + (read - '0')); // add new one.
-                    break;
-                default: break;
-            }
-        }
+    void parseBenchReset() override {
+        games.clear();
+    }
+
+private:
+    GameTable games;
+    GameConstraints CONSTRAINTS = GameConstraints { 12, 13, 14 };
 
-        return ! (g > CONSTRAINTS);
+    void finishGame(GameConstraints& game, GameConstraints& round) {
+        game.updateMin(round);
+        games.add(game);
+        game = {};
+        round = {};
     }
 };
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 2, for the embedded input mode. Same answers as Day2, computed from a string_view.
+ */
+namespace Day2::Constexpr {
+
+struct Maxima { int64_t red = 0; int64_t green = 0; int64_t blue = 0; };
+
+// "Game N: 4 blue, 7 red; ..." -> the game number, and the most of each colour seen in any round.
+constexpr Maxima gameMaxima(std::string_view line, int64_t& id) {
+    ConstexprInput::Numbers n{line};
+    n.next(id);
+
+    Maxima m;
+    int64_t count;
+    while (n.next(count)) {
+        // n.pos is right after the count, the colour follows after a space.
+        switch (line[n.pos + 1]) {
+            default: throw std::logic_error("unknown colour");
+            case 'r': m.red = std::max(m.red, count); break;
+            case 'g': m.green = std::max(m.green, count); break;
+            case 'b': m.blue = std::max(m.blue, count); break;
+        }
+    }
+    return m;
+}
+
+constexpr int64_t v1(std::string_view input) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (line.empty()) continue;
+        int64_t id = 0;
+        auto m = gameMaxima(line, id);
+        if (m.red <= 12 && m.green <= 13 && m.blue <= 14) sum += id;
+    }
+    return sum;
+}
+
+constexpr int64_t v2(std::string_view input) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (line.empty()) continue;
+        int64_t id = 0;
+        auto m = gameMaxima(line, id);
+        sum += m.red * m.green * m.blue;
+    }
+    return sum;
+}
+
+} // namespace
@@ -1,247 +1,194 @@
 #pragma once
 
 #include <iostream>
-#include <set>
-#include <map>
+#include <vector>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 3
 
+#define USE_TASK_POOL true // part numbers and gears are independent, big schematics are done in bands on the work-stealing pool.
+
 NAMESPACE_DEF(DAY) {
 
 /**
  * Retroactively added to this template, used to be a lone int main() file.
- * The original consumed the ifstream directly, which is hard to replicate with immutability.
- * To do this, we parse the input into one big string, and use a stringstream on it in the solvers.
+ * The original put nine coordinates per symbol in a std::set and looked up every digit in it (see original_solution_day_3.cpp).
+ * Now the schematic is parsed once into
+ *  - a bitmap of the symbols, one bit per cell. v1 grows it by one cell in all 8 directions with word shifts,
+ *    and a part number is a digit run with any bit set underneath it.
+ *  - a flat grid with, for every digit, the index of the number it is part of. v2 looks around every gear in it.
  */
 
-struct Gear {
-    std::vector<int> parts;
+class Bitmap {
+public:
+    Bitmap() = default;
+    Bitmap(int width, int height) : width(width), height(height), wordsPerRow((width + 63) / 64), bits(wordsPerRow * height, 0) {}
+
+    void set(int x, int y) { bits[y * wordsPerRow + x / 64] |= uint64_t{1} << (x % 64); }
+    [[nodiscard]] bool test(int x, int y) const { return (bits[y * wordsPerRow + x / 64] >> (x % 64)) & 1; }
+
+    // Every set bit also sets its 8 neighbours. Bit x of a word is column 64 * word + x,
+    // so moving a column right is a left shift, with the top bit of the word before carried in.
+    [[nodiscard]] Bitmap dilated() const {
+        Bitmap horizontal(width, height);
+        for (int y = 0; y < height; ++y) {
+            const uint64_t * in = &bits[y * wordsPerRow];
+            uint64_t * out = &horizontal.bits[y * wordsPerRow];
+            for (int w = 0; w < wordsPerRow; ++w) {
+                uint64_t fromLeft = w > 0 ? in[w - 1] >> 63 : 0;
+                uint64_t fromRight = w + 1 < wordsPerRow ? in[w + 1] << 63 : 0;
+                out[w] = in[w] | (in[w] << 1 | fromLeft) | (in[w] >> 1 | fromRight);
+            }
+        }
+
+        Bitmap result(width, height);
+        for (int y = 0; y < height; ++y) {
+            uint64_t * out = &result.bits[y * wordsPerRow];
+            for (int dy = -1; dy <= 1; ++dy) {
+                if (y + dy < 0 || y + dy >= height) continue;
+                const uint64_t * in = &horizontal.bits[(y + dy) * wordsPerRow];
+                for (int w = 0; w < wordsPerRow; ++w) out[w] |= in[w];
+            }
+        }
+        return result;
+    }
+
+    void clear() {
+        *this = Bitmap();
+    }
+
+private:
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+};
+
+struct PartNumber {
+    int value;
+    int y;
+    int x_begin;
+    int x_end; // exclusive
 };
 
 CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
-        std::ostringstream s;
-        s << input.rdbuf();
-        entire_input_string = s.str();
-    }
+    void parse(std::istream& input) override {
+        std::vector<std::string> rows;
+        std::string line;
+        while (std::getline(input, line)) {
+            if (! line.empty() && line.back() == '\r') line.pop_back();
+            if (! line.empty()) rows.emplace_back(std::move(line));
+        }
 
-    void v1() const override {
-        std::istringstream text(entire_input_string);
-        int xcoord = 0;
-        int ycoord = 0;
-
-        std::set<uint64_t> safe_spaces;
-        auto coord_to_id = [](uint64_t x, uint64_t y){ return x << 32 | y; };
-
-        int c = 0;
-        while (c != EOF) {
-            c = text.get();
-            switch (c) {
-                case '.': case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-                    break; // ignore these
-                case '\n':
-                case EOF:
-                    xcoord = -1; // disgusting. Necessary due to incrementing at the end of this loop.
-                    ycoord++;
-                    break;
-                default: // not dot, not number, is symbol.
-                    // around the dot add coords to the safe_spaces. going "out of bounds" e.g. negative nums is OK,
-                    // numbers check for safe spaces not the other way around.
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord-1));
-                    safe_spaces.emplace(coord_to_id(xcoord+0, ycoord-1));
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord-1));
-
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord+0));
-                    safe_spaces.emplace(coord_to_id(xcoord+0, ycoord+0)); // redundant.
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord+0));
-
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord+1));
-                    safe_spaces.emplace(coord_to_id(xcoord+0, ycoord+1));
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord+1));
+        height = static_cast<int>(rows.size());
+        width = height == 0 ? 0 : static_cast<int>(rows[0].size());
+        symbols = Bitmap(width, height);
+        numberAt.assign(width * height, NO_NUMBER);
+
+        for (int y = 0; y < height; ++y) {
+            const std::string& row = rows[y];
+            if (static_cast<int>(row.size()) != width) {
+                throw std::logic_error("Schematic rows must all have the same width");
             }
-            xcoord ++;
-        }
 
-        // now reset the stream.
-        text.clear();
-        text.seekg(0);
-        xcoord = 0;
-        ycoord = 0;
-
-        // and seek digits adjacent to safe spaces.
-        bool digit_parsing_mode = false;
-        bool digit_is_safe = false;
-        int parsed_number = 0;
-        int safe_numbers_sum = 0;
-
-        c = 0;
-        while (c != EOF) {
-            c = text.get();
-            switch (c) {
-                case '\n':
-                case EOF:
-                    xcoord = -1; // ugh
-                    ycoord++;
-                default:
-                    if (digit_parsing_mode && digit_is_safe) {
-                        safe_numbers_sum += parsed_number;
-                    }
-
-                    digit_parsing_mode = false;
-                    digit_is_safe = false;
-                    parsed_number = 0;
-                    break;
-                case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-                    digit_parsing_mode = true;
-                    parsed_number *= 10;
-                    parsed_number += c - '0';
-
-                    // for every digit added to the number we should check if it's on a safe space.
-                    auto coord = coord_to_id(xcoord, ycoord);
-                    if (safe_spaces.find(coord) != safe_spaces.end()) {
-                        digit_is_safe = true;
-                    }
-                    break;
+            for (int x = 0; x < width; ++x) {
+                char c = row[x];
+                if (c == '.') continue;
+                if (c < '0' || c > '9') {
+                    symbols.set(x, y);
+                    if (c == '*') gears.push_back(y * width + x);
+                    continue;
+                }
+
+                PartNumber n { 0, y, x, x };
+                for (; n.x_end < width && row[n.x_end] >= '0' && row[n.x_end] <= '9'; ++n.x_end) {
+                    n.value = n.value * 10 + (row[n.x_end] - '0');
+                    numberAt[y * width + n.x_end] = static_cast<int32_t>(numbers.size());
+                }
+                numbers.push_back(n);
+                x = n.x_end - 1;
             }
-            xcoord++;
         }
-
-        reportSolution(safe_numbers_sum);
     }
 
-    void v2() const override {
-        std::istringstream text(entire_input_string);
-        int xcoord = 0;
-        int ycoord = 0;
-
-        std::set<uint64_t> safe_spaces;
-        std::map<uint64_t, Gear> gears;
-        auto coord_to_id = [](uint64_t x, uint64_t y){ return x << 32 | y; };
-
-        int c = 0;
-        while (c != EOF) {
-            c = text.get();
-            switch (c) {
-                case '*':
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord-1));
-                    safe_spaces.emplace(coord_to_id(xcoord+0, ycoord-1));
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord-1));
-
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord+0));
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord+0));
-
-                    safe_spaces.emplace(coord_to_id(xcoord-1, ycoord+1));
-                    safe_spaces.emplace(coord_to_id(xcoord+0, ycoord+1));
-                    safe_spaces.emplace(coord_to_id(xcoord+1, ycoord+1));
-
-                    gears.insert(std::make_pair<uint64_t, Gear>(coord_to_id(xcoord, ycoord), {}));
-                    break;
-                case '\n':
-                case EOF:
-                    xcoord = -1; // disgusting. Necessary due to incrementing at the end of this loop.
-                    ycoord++;
-                    break;
-                default:
-                    break;
-            }
-            xcoord ++;
-        }
+    void v1() const override {
+        Bitmap nearSymbol = symbols.dilated();
 
-        // now reset the stream.
-        text.clear();
-        text.seekg(0);
-        xcoord = 0;
-        ycoord = 0;
-
-        // and seek digits adjacent to safe spaces.
-        bool digit_parsing_mode = false;
-        bool digit_is_safe = false;
-        int parsed_number = 0;
-
-
-        // I don't know if this is OK or super stupid.
-        // After finding a digit in a whitelisted space, what gear does it belong to? we don't know without seeking.
-        // We cant seek around it since it is a stream. So defer seeking for later, comparing it against the GearMap.
-        // This also easily enables detecting parts contributing to multiple gears, e.g. ".1*512*2.", 512 is connected to 2 gears.
-        std::vector<uint64_t> spaces_to_check_for_gears;
-
-        c = 0;
-        while (c != EOF) {
-            c = text.get();
-            switch (c) {
-                case '\n':
-                case EOF:
-                    xcoord = -1; // ugh
-                    ycoord++;
-                default:
-                    if (digit_parsing_mode && digit_is_safe) {
-                        // attaches to a '*', but which one?
-                        for (auto possible_gear : spaces_to_check_for_gears) {
-                            auto gear_seek = gears.find(possible_gear);
-                            if (gear_seek != gears.end()) {
-                                gear_seek->second.parts.push_back(parsed_number);
-                            }
-                        }
-                    }
-
-                    digit_parsing_mode = false;
-                    digit_is_safe = false;
-                    parsed_number = 0;
-                    spaces_to_check_for_gears.clear();
-                    break;
-                case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-                    digit_parsing_mode = true;
-                    parsed_number *= 10;
-                    parsed_number += c - '0';
-
-                    // for every digit added to the number we should check if it's on a safe space.
-                    auto coord = coord_to_id(xcoord, ycoord);
-                    if (safe_spaces.find(coord) != safe_spaces.end()) {
-                        if (! digit_is_safe) { // first time gear found for this digit
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord - 1, ycoord - 1));
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord - 0, ycoord - 1));
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord + 1, ycoord - 1));
-
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord - 1, ycoord - 0));
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord + 1, ycoord - 0));
-
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord - 1, ycoord + 1));
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord - 0, ycoord + 1));
-                            spaces_to_check_for_gears.push_back(coord_to_id(xcoord + 1, ycoord + 1));
-                        }
-
-                        digit_is_safe = true;
-                    }
-                    break;
+        auto partValue = [&](int64_t i) -> int64_t {
+            const PartNumber& n = numbers[i];
+            for (int x = n.x_begin; x < n.x_end; ++x) {
+                if (nearSymbol.test(x, n.y)) return n.value;
             }
-            xcoord++;
-        }
+            return 0;
+        };
+
+#if USE_TASK_POOL
+        // numbers are in row order, so a range of them is a band of rows.
+        int64_t sum = parallelReduce(0, static_cast<int64_t>(numbers.size()), int64_t{0}, partValue, std::plus<>{}, BAND);
+#else
+        int64_t sum = 0;
+        for (size_t i = 0; i < numbers.size(); ++i) sum += partValue(static_cast<int64_t>(i));
+#endif
+
+        reportSolution(sum);
+    }
 
-        uint64_t gearPowerSum = 0;
-        for (auto& kvp : gears) {
-            auto gear_parts = kvp.second.parts;
-            if (gear_parts.size() == 2) { // not a qualifying gear otherwise.
-                gearPowerSum += gear_parts[0] * gear_parts[1];
+    void v2() const override {
+        // A gear is a '*' with exactly two different numbers in the 8 cells around it.
+        auto gearRatio = [&](int64_t i) -> int64_t {
+            int gx = gears[i] % width;
+            int gy = gears[i] / width;
+
+            std::array<int32_t, 2> found { NO_NUMBER, NO_NUMBER };
+            int nFound = 0;
+            for (int y = std::max(gy - 1, 0); y <= std::min(gy + 1, height - 1); ++y) {
+                for (int x = std::max(gx - 1, 0); x <= std::min(gx + 1, width - 1); ++x) {
+                    int32_t number = numberAt[y * width + x];
+                    if (number == NO_NUMBER || number == found[0] || number == found[1]) continue;
+                    if (nFound == 2) return 0; // a third one.
+                    found[nFound++] = number;
+                }
             }
-        }
+            return nFound == 2 ? static_cast<int64_t>(numbers[found[0]].value) * numbers[found[1]].value : 0;
+        };
+
+#if USE_TASK_POOL
+        int64_t gearPowerSum = parallelReduce(0, static_cast<int64_t>(gears.size()), int64_t{0}, gearRatio, std::plus<>{}, BAND);
+#else
+        int64_t gearPowerSum = 0;
+        for (size_t i = 0; i < gears.size(); ++i) gearPowerSum += gearRatio(static_cast<int64_t>(i));
+#endif
 
         reportSolution(gearPowerSum);
     }
 
     void parseBenchReset() override {
-        entire_input_string.clear(); // might be redundant. this is only assigned to in parse, not appended.
+        symbols.clear();
+        numberAt.clear();
+        numbers.clear();
+        gears.clear();
     }
 
 private:
-    std::string entire_input_string;
+    static constexpr int32_t NO_NUMBER = -1;
+    static constexpr int64_t BAND = 8192; // numbers or gears per task. The puzzle input fits in one.
+
+    int width = 0;
+    int height = 0;
+
+    Bitmap symbols;
+    std::vector<int32_t> numberAt; // y * width + x, the index into 'numbers', or NO_NUMBER.
+    std::vector<PartNumber> numbers;
+    std::vector<int> gears; // y * width + x of every '*'.
 };
 
 }
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <bit>
 #include <iostream>
+#include <string_view>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
@@ -15,46 +17,41 @@ NAMESPACE_DEF(DAY) {
  * which is contained in the function bodies as seen here.
  */
 
+// Card numbers are < 100, so the numbers on each side of a card fit in a 128 bit mask. (the constexpr version does the same)
 struct ScratchCard {
-    std::vector<int> winningNumbers;
-    std::vector<int> yourNumbers;
+    std::array<uint64_t, 2> winningNumbers {0, 0};
+    std::array<uint64_t, 2> yourNumbers {0, 0};
 
     ScratchCard() = delete;
-    explicit ScratchCard(const std::string& from) {
-        auto start_of_winners = from.find(':');
-        auto start_of_mine = from.find('|');
-
-        // '+1' to offset for the token itself. This makes parsing into ints easier.
-        auto winString = from.substr(start_of_winners + 1, start_of_mine - (start_of_winners + 1));
-        auto myString = from.substr(start_of_mine + 1);
-
-        auto tokenize = [](const std::string& from, std::vector<int>& into) {
-            std::istringstream s(from);
-            int x;
-            while (s >> x) {
-                into.push_back(x);
+    explicit ScratchCard(std::string_view from) {
+        auto colon = from.find(':');
+        if (colon == std::string_view::npos) throw std::logic_error("Cards look like 'Card N: ...', got '" + std::string(from) + "'");
+
+        auto* into = &winningNumbers;
+        int number = 0;
+        bool inNumber = false;
+        for (char c : from.substr(colon + 1)) {
+            if (c >= '0' && c <= '9') {
+                number = number * 10 + (c - '0');
+                inNumber = true;
+                continue;
             }
-        };
-
-        tokenize(winString, winningNumbers);
-        tokenize(myString, yourNumbers);
+            if (inNumber) add(*into, number);
+            number = 0;
+            inNumber = false;
+            if (c == '|') into = &yourNumbers;
+        }
+        if (inNumber) add(*into, number);
     }
 
     [[nodiscard]] int n_wins() const {
-        int wins = 0;
-        for (auto& number : yourNumbers) {
-            for (auto& winner : winningNumbers) {
-                if (number == winner) {
-                    wins ++;
-                    break;
-                }
-            }
-        }
-        return wins;
+        return std::popcount(winningNumbers[0] & yourNumbers[0]) + std::popcount(winningNumbers[1] & yourNumbers[1]);
     }
 
-    [[nodiscard]] int score() const {
-        return (1 << n_wins()) / 2;
+private:
+    static void add(std::array<uint64_t, 2>& mask, int n) {
+        if (n >= 128) throw std::logic_error("Card numbers must be below 128, got " + std::to_string(n));
+        mask[n / 64] |= uint64_t{1} << (n % 64);
     }
 };
 
@@ -62,45 +59,49 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+    // Only the number of wins of every card matters to v1 and v2, so that is all that is kept.
+    void parse(std::istream& input) override {
         std::string line;
         while (std::getline(input, line)) {
-            ScratchCard c(line);
-            cards.push_back(c);
+            if (line.empty()) continue;
+            wins.push_back(static_cast<uint8_t>(ScratchCard(line).n_wins()));
         }
     }
 
     void v1() const override {
-        int totalScore = std::accumulate(cards.begin(), cards.end(), 0, [](int sum, auto& c){
-            return sum + c.score();
+        int64_t totalScore = std::accumulate(wins.begin(), wins.end(), int64_t{0}, [](int64_t sum, uint8_t w){
+            if (w > 63) throw std::logic_error("A card with " + std::to_string(w) + " wins scores more than 64 bits");
+            return sum + (w == 0 ? 0 : int64_t{1} << (w - 1));
         });
 
         reportSolution(totalScore);
     }
 
+    // Card i adds its instance count to the next wins[i] cards. Instead of adding it to each of them,
+    // add it once at the start of the range and take it away again after the end; a running sum over that gives the counts.
     void v2() const override {
-        std::vector<int> instancesOfCard;
-        instancesOfCard.resize(cards.size(), 1);
-        int index = 0;
-        std::for_each(cards.begin(), cards.end(), [&instancesOfCard, &index](auto& c) {
-            int wins = c.n_wins();
-            for (int i = index+1; i < index+1 + wins && i < instancesOfCard.size(); ++i) {
-                instancesOfCard[i] += instancesOfCard[index];
-            }
-
-            index++;
-        });
+        std::vector<int64_t> difference(wins.size() + 1, 0);
+        int64_t copies = 0;
+        int64_t sum = 0;
+        for (size_t i = 0; i < wins.size(); ++i) {
+            copies += difference[i];
+            int64_t instances = 1 + copies;
+            sum += instances;
+
+            size_t end = std::min(i + 1 + wins[i], wins.size());
+            difference[i + 1] += instances;
+            difference[end] -= instances;
+        }
 
-        int sum = std::accumulate(instancesOfCard.begin(), instancesOfCard.end(), 0);
         reportSolution(sum);
     }
 
     void parseBenchReset() override {
-        cards.clear();
+        wins.clear();
     }
 
 private:
-    std::vector<ScratchCard> cards;
+    std::vector<uint8_t> wins; // ScratchCard::n_wins() of every card, in order.
 };
 
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 4, for the embedded input mode. Same answers as Day4, computed from a string_view.
+ */
+namespace Day4::Constexpr {
+
+// "Card N: winning | yours" -> how many of yours are winning. Numbers are < 100, so a 128 bit mask holds them.
+constexpr int wins(std::string_view line) {
+    auto colon = line.find(':');
+    auto bar = line.find('|');
+    if (colon == std::string_view::npos || bar == std::string_view::npos || bar < colon) throw std::logic_error("not a card");
+
+    uint64_t winning[2] = { 0, 0 };
+    ConstexprInput::Numbers w{line.substr(colon + 1, bar - colon - 1)};
+    int64_t n;
+    while (w.next(n)) winning[n / 64] |= 1ull << (n % 64);
+
+    int count = 0;
+    ConstexprInput::Numbers y{line.substr(bar + 1)};
+    while (y.next(n)) count += (winning[n / 64] >> (n % 64)) & 1;
+
+    return count;
+}
+
+constexpr int64_t v1(std::string_view input) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (line.empty()) continue;
+        int w = wins(line);
+        if (w > 0) sum += int64_t{1} << (w - 1);
+    }
+    return sum;
+}
+
+constexpr int64_t v2(std::string_view input) {
+    std::vector<int> cardWins;
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    while (lines.next(line)) {
+        if (! line.empty()) cardWins.push_back(wins(line));
+    }
+
+    std::vector<int64_t> instances(cardWins.size(), 1);
+    int64_t total = 0;
+    for (size_t i = 0; i < cardWins.size(); ++i) {
+        total += instances[i];
+        for (size_t j = i + 1; j <= i + cardWins[i] && j < cardWins.size(); ++j) {
+            instances[j] += instances[i];
+        }
+    }
+    return total;
+}
+
+} // namespace
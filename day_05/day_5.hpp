@@ -2,10 +2,10 @@
 
 #include <iostream>
 #include <omp.h>
-#include <syncstream>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
+#include "day_5_simd.hpp"
 
 #define DAY 5
 
@@ -113,21 +113,123 @@ std::ostream& operator<<(std::ostream& o, const Range& r) {
     return o;
 }
 
+/**
+ * A function on the non-negative integers that adds a constant offset per interval: f(x) = x + offsets[i] for starts[i] <= x < starts[i + 1].
+ * The last interval goes on forever. Every layer of the almanac is one of these, and so is any composition of them,
+ * so all layers can be folded into a single IntervalMap up front.
+ */
+class IntervalMap {
+public:
+    IntervalMap() : starts{0}, offsets{0} {} // identity
+
+    // one layer: every (offset, range) moves that range by offset, everything else stays put.
+    static IntervalMap fromRules(std::vector<std::pair<int64_t, Range>> rules) {
+        std::sort(rules.begin(), rules.end(), [](auto& a, auto& b) { return a.second.start < b.second.start; });
+
+        IntervalMap m;
+        m.starts.clear();
+        m.offsets.clear();
+        int64_t covered = 0; // everything below this has a piece already.
+        for (auto& [offset, range] : rules) {
+            assert(range.start >= covered, "Overlapping rules in one layer of the almanac");
+            if (range.start > covered) m.push(covered, 0);
+            m.push(range.start, offset);
+            covered = range.end + 1;
+        }
+        m.push(covered, 0);
+        return m;
+    }
+
+    [[nodiscard]] int64_t operator()(int64_t x) const {
+        return x + offsets[pieceOf(x)];
+    }
+
+    // The piece that x falls in.
+    [[nodiscard]] size_t pieceOf(int64_t x) const {
+        return std::upper_bound(starts.begin(), starts.end(), x) - starts.begin() - 1;
+    }
+
+    // (then(*this))(x), i.e. first this one, then 'then'. Each piece of this one is cut where its image crosses a start of 'then'.
+    [[nodiscard]] IntervalMap andThen(const IntervalMap& then) const {
+        IntervalMap result;
+        result.starts.clear();
+        result.offsets.clear();
+        for (size_t i = 0; i < starts.size(); ++i) {
+            int64_t begin = starts[i];
+            int64_t end = pieceEnd(i);
+            int64_t offset = offsets[i];
+
+            for (size_t j = then.pieceOf(begin + offset); j < then.starts.size() && then.starts[j] < end + offset; ++j) {
+                result.push(std::max(begin, then.starts[j] - offset), offset + then.offsets[j]);
+            }
+        }
+        return result;
+    }
+
+    // The lowest f(x) for x in [begin, end]. Within a piece f only goes up, so only the first x of every piece can be the lowest.
+    // An empty range (end < begin, a seed range of length 0) has no lowest, that is int64 max.
+    [[nodiscard]] int64_t lowestOn(int64_t begin, int64_t end) const {
+        int64_t lowest = std::numeric_limits<int64_t>::max();
+        if (end < begin) return lowest;
+        for (size_t i = pieceOf(begin); i < starts.size() && starts[i] <= end; ++i) {
+            lowest = std::min(lowest, std::max(begin, starts[i]) + offsets[i]);
+        }
+        return lowest;
+    }
+
+    [[nodiscard]] size_t size() const { return starts.size(); }
+
+private:
+    static constexpr int64_t UNBOUNDED = int64_t{1} << 62; // the end of the last piece. far enough, and offsets do not overflow it.
+
+    std::vector<int64_t> starts;
+    std::vector<int64_t> offsets;
+
+    [[nodiscard]] int64_t pieceEnd(size_t i) const { return i + 1 < starts.size() ? starts[i + 1] : UNBOUNDED; } // exclusive
+
+    // adds a piece, or grows the last one if it has the same offset.
+    void push(int64_t start, int64_t offset) {
+        if (! offsets.empty() && offsets.back() == offset) return;
+        starts.push_back(start);
+        offsets.push_back(offset);
+    }
+};
+
 CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+    void parse(std::istream& input) override {
         // Janky due to retroactively applying the new, immutable-during-solving template.
         // the 2 parse functions do not have overlap, other than re-assigning seed_numbers a string, which is harmless.
         parseInput(input);
         input.clear();
         input.seekg(0);
         parseAsProblem2(input);
+
+        std::istringstream seed_reader(seed_string_numbers);
+        int64_t seed;
+        while (seed_reader >> seed) seeds.push_back(seed);
+
+        for (auto& layer : mapping_ranges) {
+            almanac = almanac.andThen(IntervalMap::fromRules(layer));
+
+            for (auto& [offset, range] : layer) flat_layers.addRule(range.start, range.end, offset);
+            flat_layers.endLayer();
+        }
     }
 
+#define INTERVAL_MAP_SOLUTION true // all layers composed into one IntervalMap, at parse time.
+
     void v1() const override {
+#if INTERVAL_MAP_SOLUTION
+        int64_t lowest = std::numeric_limits<int64_t>::max();
+        for (int64_t seed : seeds) {
+            lowest = std::min(lowest, almanac(seed));
+        }
 
+        reportSolution(lowest);
+#else
         std::istringstream seed_reader(seed_string_numbers);
 
         int64_t seed;
@@ -141,12 +243,20 @@ public:
         }
 
         reportSolution(lowest);
+#endif
     }
 
 #define SMART_SOLUTION true
 
     void v2() const override {
-#if SMART_SOLUTION
+#if INTERVAL_MAP_SOLUTION
+        int64_t global_min = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i + 1 < seeds.size(); i += 2) {
+            global_min = std::min(global_min, almanac.lowestOn(seeds[i], seeds[i] + seeds[i + 1] - 1));
+        }
+
+        reportSolution(global_min);
+#elif SMART_SOLUTION
 
         std::istringstream seed_reader(seed_string_numbers);
 
@@ -241,66 +351,52 @@ public:
 
         reportSolution(global_min);
 #else
-        std::istringstream seed_reader(seed_string_numbers);
+        // Every seed, the hard way. Seed ranges are cut into chunks that threads take as they go: all chunks cost about the same,
+        // but the threads may not run equally fast. Each chunk only hands back its lowest location.
+        constexpr int64_t CHUNK = 1 << 20;
 
-        std::vector<std::pair<int64_t, int64_t>> seed_groups;
-
-        int64_t start_seed;
-        int64_t seed_range;
-        while (seed_reader >> start_seed >> seed_range) {
-            seed_groups.emplace_back(start_seed, seed_range);
+        std::istringstream seed_reader(seed_string_numbers);
+        std::vector<std::pair<int64_t, int64_t>> chunks;
+        int64_t total = 0;
+        {
+            int64_t start_seed;
+            int64_t seed_range;
+            while (seed_reader >> start_seed >> seed_range) {
+                for (int64_t s = 0; s < seed_range; s += CHUNK) {
+                    chunks.emplace_back(start_seed + s, std::min(CHUNK, seed_range - s));
+                }
+                total += seed_range;
+            }
         }
 
-        std::vector<int64_t> results;
+        std::cout << "Crunching " << total << " seeds on " << omp_get_max_threads() << " threads\n";
+        auto start = std::chrono::steady_clock::now();
 
         int64_t global_min = std::numeric_limits<int64_t>::max();
-        for (int i = 0; i < seed_groups.size(); ++i) {
-            auto& [seed, range] = seed_groups[i];
-            std::cout << "Alloc " << range << " Items. (" << (range * sizeof(int64_t)) / static_cast<double>(1 << 30) << " GiB)\n";
-            results.resize(range);
-
-            std::cout << "Crunching " << range << " Items\n";
-            auto start = std::chrono::steady_clock::now();
-
-#pragma omp parallel for schedule(static) shared(std::cout, seed, range, results) default(none)
-            for (int64_t s = seed; s < seed + range; ++s) {
-                std::osyncstream(std::cout) << omp_get_thread_num() << "\n";
-                uint64_t remap_result = remapper.remap(s);
-                results[s-seed] = remap_result;
-            }
-
-            auto duration = std::chrono::steady_clock::now() - start;
-            double sec = (duration.count() / 1'000'000'000.0);
-            std::cout << "The crunch took " << sec << " seconds: " << (range / sec) << " items per second\n";
-            std::cout << "Take local min of these items:\n";
-            int64_t local_min = std::numeric_limits<int64_t>::max();
-
-#pragma omp parallel for simd schedule(static) default(none) reduction(min:local_min) shared(results)
-            for (int j = 0; j < results.size(); ++j) {
-                if (results[j] < local_min) {
-                    local_min = results[j];
-                }
-            }
-            std::cout << "\tLocal min is: " << local_min << "\n";
-            results.clear(); // technically redundant.
-
-            if (local_min < global_min) {
-                global_min = local_min;
-            }
+#pragma omp parallel for schedule(dynamic, 1) reduction(min:global_min) default(none) shared(chunks)
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            global_min = std::min(global_min, Simd::lowest(flat_layers, chunks[c].first, chunks[c].second));
         }
 
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "The crunch took " << sec << " seconds: " << (static_cast<double>(total) / sec) << " seeds per second\n";
+
         reportSolution(global_min);
 #endif
     }
 
 private:
-    NumberMapper remapper; // problem 1 and old problem 2 solution
+    NumberMapper remapper; // problem 1 without the interval map
 
     std::vector<std::vector<std::pair<int64_t, Range>>> mapping_ranges; // problem 2 solution.
 
     std::string seed_string_numbers;
 
-    void parseInput(std::ifstream& input) {
+    std::vector<int64_t> seeds;
+    IntervalMap almanac; // seed -> location
+    Simd::FlatLayers flat_layers; // the brute force, not smart solution.
+
+    void parseInput(std::istream& input) {
         std::string line;
         std::getline(input, line);
 
@@ -365,7 +461,7 @@ private:
         }
     }
 
-    void parseAsProblem2(std::ifstream& text) {
+    void parseAsProblem2(std::istream& text) {
         std::string line;
         std::getline(text, line);
 
@@ -404,6 +500,9 @@ private:
     void parseBenchReset() override {
         mapping_ranges.clear();
         remapper = NumberMapper{};
+        seeds.clear();
+        almanac = IntervalMap{};
+        flat_layers.clear();
     }
 
 };
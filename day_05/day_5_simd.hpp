@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../util/Cpu.hpp"
+
+/**
+ * The brute force for day 5 part 2: push every single seed through every layer, keep the lowest location.
+ * Billions of seeds, so it doubles as a throughput test. The rules of all layers sit back to back in flat arrays,
+ * and a kernel takes a run of consecutive seeds and only returns the lowest location; nothing is stored per seed.
+ * The rules of a layer do not overlap, so a seed is moved by at most one of them per layer, and the order does not matter.
+ */
+namespace Day5::Simd {
+
+struct FlatLayers {
+    // inclusive ranges, of all layers.
+    std::vector<int64_t> start;
+    std::vector<int64_t> end;
+    std::vector<int64_t> offset;
+    std::vector<size_t> layerEnd; // one past the last rule of every layer.
+
+    void addRule(int64_t s, int64_t e, int64_t o) {
+        start.push_back(s);
+        end.push_back(e);
+        offset.push_back(o);
+    }
+
+    void endLayer() { layerEnd.push_back(start.size()); }
+
+    [[nodiscard]] int64_t remap(int64_t x) const {
+        size_t rule = 0;
+        for (size_t layer_end : layerEnd) {
+            int64_t mapped = x;
+            for (; rule < layer_end; ++rule) {
+                if (x >= start[rule] && x <= end[rule]) mapped = x + offset[rule];
+            }
+            x = mapped;
+        }
+        return x;
+    }
+
+    void clear() {
+        start.clear();
+        end.clear();
+        offset.clear();
+        layerEnd.clear();
+    }
+};
+
+// lowest location for the seeds [first, first + count).
+inline int64_t lowestScalar(const FlatLayers& t, int64_t first, int64_t count) {
+    int64_t lowest = std::numeric_limits<int64_t>::max();
+    for (int64_t s = first; s < first + count; ++s) {
+        lowest = std::min(lowest, t.remap(s));
+    }
+    return lowest;
+}
+
+#if AOC_X86 == true
+// Within a layer every rule waits for the blend of the rule before it, so a single vector of seeds mostly sits and waits.
+// UNROLL independent vectors go through the rules side by side to fill that up, and share the broadcasts of each rule.
+constexpr int UNROLL = 4;
+
+__attribute__((target("avx2"))) inline int64_t lowestAvx2(const FlatLayers& t, int64_t first, int64_t count) {
+    constexpr int64_t LANES = 4;
+    const int64_t vectorCount = count / (LANES * UNROLL) * (LANES * UNROLL);
+
+    __m256i x0[UNROLL];
+    for (int u = 0; u < UNROLL; ++u) x0[u] = _mm256_add_epi64(_mm256_set1_epi64x(first + u * LANES), _mm256_setr_epi64x(0, 1, 2, 3));
+    const __m256i step = _mm256_set1_epi64x(LANES * UNROLL);
+    __m256i lowest = _mm256_set1_epi64x(std::numeric_limits<int64_t>::max());
+
+    for (int64_t i = 0; i < vectorCount; i += LANES * UNROLL) {
+        __m256i x[UNROLL];
+        for (int u = 0; u < UNROLL; ++u) x[u] = x0[u];
+
+        size_t rule = 0;
+        for (size_t layer_end : t.layerEnd) {
+            __m256i mapped[UNROLL];
+            for (int u = 0; u < UNROLL; ++u) mapped[u] = x[u];
+
+            for (; rule < layer_end; ++rule) {
+                const __m256i s = _mm256_set1_epi64x(t.start[rule]);
+                const __m256i e = _mm256_set1_epi64x(t.end[rule]);
+                const __m256i o = _mm256_set1_epi64x(t.offset[rule]);
+                for (int u = 0; u < UNROLL; ++u) {
+                    // no 'greater or equal' compares for 64 bit lanes, so the test is inverted: outside = s > x || x > e.
+                    __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(s, x[u]), _mm256_cmpgt_epi64(x[u], e));
+                    mapped[u] = _mm256_blendv_epi8(_mm256_add_epi64(x[u], o), mapped[u], outside);
+                }
+            }
+            for (int u = 0; u < UNROLL; ++u) x[u] = mapped[u];
+        }
+
+        for (int u = 0; u < UNROLL; ++u) {
+            lowest = _mm256_blendv_epi8(lowest, x[u], _mm256_cmpgt_epi64(lowest, x[u])); // no min_epi64 before AVX-512 either.
+            x0[u] = _mm256_add_epi64(x0[u], step);
+        }
+    }
+
+    alignas(32) int64_t lanes[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), lowest);
+    return std::min(lowestScalar(t, first + vectorCount, count - vectorCount), *std::min_element(lanes, lanes + LANES));
+}
+
+__attribute__((target("avx512f"))) inline int64_t lowestAvx512(const FlatLayers& t, int64_t first, int64_t count) {
+    constexpr int64_t LANES = 8;
+    const int64_t vectorCount = count / (LANES * UNROLL) * (LANES * UNROLL);
+
+    __m512i x0[UNROLL];
+    for (int u = 0; u < UNROLL; ++u) x0[u] = _mm512_add_epi64(_mm512_set1_epi64(first + u * LANES), _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m512i step = _mm512_set1_epi64(LANES * UNROLL);
+    __m512i lowest = _mm512_set1_epi64(std::numeric_limits<int64_t>::max());
+
+    for (int64_t i = 0; i < vectorCount; i += LANES * UNROLL) {
+        __m512i x[UNROLL];
+        for (int u = 0; u < UNROLL; ++u) x[u] = x0[u];
+
+        size_t rule = 0;
+        for (size_t layer_end : t.layerEnd) {
+            __m512i mapped[UNROLL];
+            for (int u = 0; u < UNROLL; ++u) mapped[u] = x[u];
+
+            for (; rule < layer_end; ++rule) {
+                const __m512i s = _mm512_set1_epi64(t.start[rule]);
+                const __m512i e = _mm512_set1_epi64(t.end[rule]);
+                const __m512i o = _mm512_set1_epi64(t.offset[rule]);
+                for (int u = 0; u < UNROLL; ++u) {
+                    __mmask8 inside = _mm512_cmpge_epi64_mask(x[u], s) & _mm512_cmple_epi64_mask(x[u], e);
+                    mapped[u] = _mm512_mask_add_epi64(mapped[u], inside, x[u], o);
+                }
+            }
+            for (int u = 0; u < UNROLL; ++u) x[u] = mapped[u];
+        }
+
+        for (int u = 0; u < UNROLL; ++u) {
+            lowest = _mm512_min_epi64(lowest, x[u]);
+            x0[u] = _mm512_add_epi64(x0[u], step);
+        }
+    }
+
+    return std::min<int64_t>(lowestScalar(t, first + vectorCount, count - vectorCount), _mm512_reduce_min_epi64(lowest));
+}
+#endif
+
+inline int64_t lowest(const FlatLayers& t, int64_t first, int64_t count) {
+#if AOC_X86 == true
+    if (Cpu::haveAvx512()) return lowestAvx512(t, first, count);
+    if (Cpu::haveAvx2()) return lowestAvx2(t, first, count);
+#endif
+    return lowestScalar(t, first, count);
+}
+
+} // namespace
@@ -2,9 +2,11 @@
 
 #include <iostream>
 #include <cmath>
+#include <numeric>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
+#include "day_6_exact.hpp"
 
 #define DAY 6
 
@@ -14,34 +16,29 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
-        int c;
-        while((c = input.get()) != EOF && c != ':')
-            ;
-
-        {
-            int n;
-            while (input >> n) {
-                race_times.push_back(n);
-            }
-            input.clear();
-        }
-
-        while((c = input.get()) != EOF && c != ':')
-            ;
-
-        {
-            int n;
-            while (input >> n) {
-                race_distances.push_back(n);
-            }
-            input.clear();
-        }
+    // Numbers are read digit by digit: each list is kept as int64 for v1, and the digits of all of them kerned into an int128 for v2.
+    void parse(std::istream& input) override {
+        readList(input, race_times, kerned_time);
+        readList(input, race_distances, kerned_distance);
 
         if (race_distances.size() != race_times.size()) throw std::logic_error("Race and Dist number vectors should have equal size");
     }
 
+#define EXACT_SOLVER true // integer square roots in (up to) 128 bits, instead of doubles and epsilons. See day_6_exact.hpp.
     void v1() const override {
+#if EXACT_SOLVER
+        std::vector<int64_t> wins_per_game;
+        Exact::waysToWin(race_times, race_distances, wins_per_game);
+
+        int64_t product = 1;
+        for (int64_t wins : wins_per_game) {
+            if (__builtin_mul_overflow(product, wins, &product)) {
+                reportSolution("the product of the ways to win does not fit in 64 bits");
+                return;
+            }
+        }
+        reportSolution(product);
+#else
 
         std::vector<int> wins_per_game;
         wins_per_game.reserve(race_distances.size());
@@ -59,9 +56,21 @@ public:
             return s * x;
         });
         reportSolution(product);
+#endif
     }
 
     void v2() const override {
+#if EXACT_SOLVER
+        if (kerned_time == KERNING_OVERFLOW || kerned_distance == KERNING_OVERFLOW) {
+            reportSolution("the kerned race does not fit in 128 bits");
+            return;
+        }
+        if (kerned_time >= Exact::MAX_TIME) {
+            reportSolution("the kerned race time is not below 2^63, the limit of the exact solver");
+            return;
+        }
+        reportSolution(static_cast<int64_t>(Exact::waysToWin(kerned_time, kerned_distance)));
+#else
 
         auto kerning = [](auto& vec) {
             int64_t kerned = 0;
@@ -84,11 +93,48 @@ public:
         auto [low, hi] = find_integer_zeroes(static_cast<double>(kerned_time), static_cast<double>(kerned_dist) + 0.1); // bigger epsilon due to size.
 
         reportSolution(hi - low + 1);
+#endif
+    }
+
+    void parseBenchReset() override {
+        race_times.clear();
+        race_distances.clear();
+        kerned_time = 0;
+        kerned_distance = 0;
     }
 
 private:
     std::vector<int64_t> race_times;
     std::vector<int64_t> race_distances;
+    static constexpr Exact::int128 KERNING_OVERFLOW = -1;
+    Exact::int128 kerned_time = 0;
+    Exact::int128 kerned_distance = 0;
+
+    // "Label:   1  2  3\n" -> into, and the digits of all numbers in a row into kerned.
+    static void readList(std::istream& input, std::vector<int64_t>& into, Exact::int128& kerned) {
+        int c;
+        while ((c = input.get()) != EOF && c != ':')
+            ;
+
+        bool inNumber = false;
+        while ((c = input.get()) != EOF && c != '\n') {
+            if (c < '0' || c > '9') {
+                inNumber = false;
+                continue;
+            }
+            if (! inNumber) into.push_back(0);
+            inNumber = true;
+
+            int64_t& n = into.back();
+            if (__builtin_mul_overflow(n, 10, &n) || __builtin_add_overflow(n, c - '0', &n)) {
+                throw std::logic_error("Race number too big");
+            }
+            // with many races, part 2 just does not exist. That should not stop part 1.
+            if (kerned >= 0 && (__builtin_mul_overflow(kerned, 10, &kerned) || __builtin_add_overflow(kerned, c - '0', &kerned))) {
+                kerned = KERNING_OVERFLOW;
+            }
+        }
+    }
 
     static std::pair<int, int> find_integer_zeroes(double time, double dist) {
         // equation: dist = speed * (time-speed),  find zeroes to see tipping point of win/lose.
@@ -108,11 +154,6 @@ private:
 
         return std::make_pair(lower_bound, upper_bound);
     }
-
-    void parseBenchReset() override {
-        race_times.clear();
-        race_distances.clear();
-    }
 };
 
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string_view>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 6, for the embedded input mode. Same answers as Day6, computed from a string_view.
+ * No sqrt in constant expressions, so the tipping point is found with a binary search on integers instead. (no epsilons either)
+ */
+namespace Day6::Constexpr {
+
+// Number of hold times s in [0, t] for which s * (t - s) > d.
+constexpr int64_t waysToWin(int64_t t, int64_t d) {
+    // s * (t - s) rises up to t / 2. Find the first s in [0, t / 2] that beats d.
+    int64_t lo = 0;
+    int64_t hi = t / 2 + 1;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (mid * (t - mid) > d) hi = mid;
+        else lo = mid + 1;
+    }
+    if (lo > t / 2) return 0;
+    return t - 2 * lo + 1; // symmetric around t / 2.
+}
+
+constexpr int64_t v1(std::string_view input) {
+    auto newline = input.find('\n');
+    ConstexprInput::Numbers times{input.substr(0, newline)};
+    ConstexprInput::Numbers distances{input.substr(newline + 1)};
+
+    int64_t product = 1;
+    int64_t t, d;
+    while (times.next(t) && distances.next(d)) {
+        product *= waysToWin(t, d);
+    }
+    return product;
+}
+
+// all digits on the line as one number, ignoring the spaces.
+constexpr int64_t kerned(std::string_view line) {
+    int64_t n = 0;
+    for (char c : line) {
+        if (ConstexprInput::isDigit(c)) n = n * 10 + (c - '0');
+    }
+    return n;
+}
+
+constexpr int64_t v2(std::string_view input) {
+    auto newline = input.find('\n');
+    return waysToWin(kerned(input.substr(0, newline)), kerned(input.substr(newline + 1)));
+}
+
+} // namespace
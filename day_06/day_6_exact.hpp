@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../util/Cpu.hpp"
+
+/**
+ * Day 6 without floating point. Holding the button for s ms out of t goes s * (t - s) far, and that has to beat d.
+ * The smallest winning s follows from the integer square root of the discriminant t^2 - 4d, give or take one,
+ * which is then settled by trying it. Everything fits in 128 bits as long as t < 2^63.
+ */
+namespace Day6::Exact {
+
+using int128 = __int128;
+using uint128 = unsigned __int128;
+
+// Newton for floor(sqrt(n)), started from the double square root, which is within a few ulps.
+// One step from anywhere lands at or above floor(sqrt(n)), after that it comes down monotonically and stops there.
+template<typename U>
+U newtonSqrt(U n) {
+    U x = std::max<U>(static_cast<U>(std::sqrt(static_cast<double>(n))), 1);
+    x = (x + n / x) / 2;
+    while (true) {
+        U y = (x + n / x) / 2;
+        if (y >= x) return x;
+        x = y;
+    }
+}
+
+// floor(sqrt(n)). 128 bit division is a library call, so anything that fits in 64 bits gets the 64 bit Newton.
+inline uint128 isqrt(uint128 n) {
+    if (n < 2) return n;
+    uint128 x = (n >> 64) == 0 ? newtonSqrt<uint64_t>(static_cast<uint64_t>(n)) : newtonSqrt<uint128>(n);
+
+    // the correction. Newton should already be exactly there, this is just to be sure.
+    while (x * x > n) --x;
+    while ((x + 1) * (x + 1) <= n) ++x;
+    return x;
+}
+
+constexpr int128 MAX_TIME = int128{1} << 63;
+
+// How many whole s in [0, t] have s * (t - s) > d.
+inline int128 waysToWin(int128 t, int128 d) {
+    if (t < 0 || d < 0) throw std::logic_error("race time and distance can not be negative");
+    if (t >= MAX_TIME) throw std::logic_error("race time must be below 2^63 for the 128 bit solver");
+
+    auto beats = [t, d](int128 s) { return s * (t - s) > d; };
+
+    if (d >= t * t / 4) return 0; // the best is s = t / 2. This also keeps 4d from overflowing.
+    int128 discriminant = t * t - 4 * d;
+
+    // the lower root is (t - sqrt(D)) / 2, the first whole s past it is about one more than that.
+    int128 low = (t - static_cast<int128>(isqrt(static_cast<uint128>(discriminant)))) / 2;
+    while (low <= t / 2 && ! beats(low)) ++low;
+    while (low > 0 && beats(low - 1)) --low;
+
+    if (! beats(low)) return 0;
+    return (t - low) - low + 1; // the highest winning s is t - low, by symmetry.
+}
+
+/**
+ * Many races at once, for v1: out[i] = waysToWin(times[i], distances[i]).
+ * With t < 2^26 everything fits a double exactly, so the square root can be taken 4 at a time in doubles,
+ * and the +-1 correction done in 64 bit lanes. Anything bigger goes through waysToWin().
+ */
+constexpr int64_t BATCH_TIME_LIMIT = int64_t{1} << 26;
+constexpr int64_t BATCH_DIST_LIMIT = int64_t{1} << 50;
+
+inline bool fitsBatch(int64_t t, int64_t d) { return t >= 0 && t < BATCH_TIME_LIMIT && d >= 0 && d < BATCH_DIST_LIMIT; }
+
+#if AOC_X86 == true
+// 0 <= x < 2^52 only: put x in the mantissa of 2^52 and take 2^52 off again. AVX2 has no int64 <-> double conversion.
+__attribute__((target("avx2"))) inline __m256d toDouble(__m256i x) {
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0); // 2^52
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, _mm256_castpd_si256(magic))), magic);
+}
+
+__attribute__((target("avx2"))) inline __m256i toInt(__m256d x) { // same range, x must be whole.
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+    return _mm256_xor_si256(_mm256_castpd_si256(_mm256_add_pd(x, magic)), _mm256_castpd_si256(magic));
+}
+
+// s * (t - s) > d. s and t - s are below 2^31 in absolute value, so the 32 bit multiply is enough.
+__attribute__((target("avx2"))) inline __m256i beats(__m256i s, __m256i t, __m256i d) {
+    return _mm256_cmpgt_epi64(_mm256_mul_epi32(s, _mm256_sub_epi64(t, s)), d);
+}
+
+__attribute__((target("avx2"))) inline void waysToWinAvx2(const int64_t * times, const int64_t * distances, int64_t * out) {
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(distances));
+
+    __m256d td = toDouble(t);
+    __m256d discriminant = _mm256_sub_pd(_mm256_mul_pd(td, td), _mm256_mul_pd(_mm256_set1_pd(4.0), toDouble(d)));
+    discriminant = _mm256_max_pd(discriminant, _mm256_setzero_pd()); // no wins at all then, 'beats' below sorts that out.
+
+    __m256d lowRoot = _mm256_mul_pd(_mm256_sub_pd(td, _mm256_sqrt_pd(discriminant)), _mm256_set1_pd(0.5));
+    __m256i low = _mm256_add_epi64(toInt(_mm256_floor_pd(lowRoot)), one);
+
+    // the double is at most a little off, one step either way settles it.
+    low = _mm256_add_epi64(low, _mm256_andnot_si256(beats(low, t, d), one));
+    __m256i below = _mm256_sub_epi64(low, one);
+    low = _mm256_sub_epi64(low, _mm256_and_si256(_mm256_and_si256(beats(below, t, d), _mm256_cmpgt_epi64(low, _mm256_setzero_si256())), one));
+
+    __m256i ways = _mm256_add_epi64(_mm256_sub_epi64(t, _mm256_add_epi64(low, low)), one);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_and_si256(ways, beats(low, t, d)));
+}
+#endif
+
+inline void waysToWin(const std::vector<int64_t>& times, const std::vector<int64_t>& distances, std::vector<int64_t>& out) {
+    out.resize(times.size());
+    size_t i = 0;
+#if AOC_X86 == true
+    if (Cpu::haveAvx2()) {
+        for (; i + 4 <= times.size(); i += 4) {
+            bool fits = true;
+            for (size_t j = i; j < i + 4; ++j) fits &= fitsBatch(times[j], distances[j]);
+            if (fits) {
+                waysToWinAvx2(&times[i], &distances[i], &out[i]);
+            } else {
+                for (size_t j = i; j < i + 4; ++j) out[j] = static_cast<int64_t>(waysToWin(times[j], distances[j]));
+            }
+        }
+    }
+#endif
+    for (; i < times.size(); ++i) out[i] = static_cast<int64_t>(waysToWin(times[i], distances[i]));
+}
+
+} // namespace
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <numeric>
+#include <vector>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 7
 
+#define LOOKUP_TABLE_CLASSIFIER true // hand types come out of a compile time table instead of a histogram.
+
 NAMESPACE_DEF(DAY) {
 
 // ordered from weakest to strongest, for use in sorting with operator<.
@@ -22,6 +29,64 @@ enum class HandType : int8_t {
 
 constexpr int JOKER_VALUE = 1;
 
+/**
+ * The type of a hand only depends on the number of jokers and on the shape of the other cards: how many of each, sorted.
+ * That shape is told apart by the number of equal pairs among the cards alone. For 5 cards:
+ * 5 -> 10, 4+1 -> 6, 3+2 -> 4, 3+1+1 -> 3, 2+2+1 -> 2, 2+1+1+1 -> 1, 1+1+1+1+1 -> 0, and fewer cards only have a subset of these.
+ * Given the joker count, the number of other cards is known, so [jokers][pairs] is the whole signature.
+ */
+namespace Classifier {
+
+constexpr int MAX_PAIRS = 10;
+using Table = std::array<std::array<HandType, MAX_PAIRS + 1>, 6>;
+
+// jokers always join the biggest group.
+constexpr HandType typeOf(int largest, int second) {
+    switch (largest) {
+        case 5: return HandType::FIVE_KIND;
+        case 4: return HandType::FOUR_KIND;
+        case 3: return second == 2 ? HandType::FULL_HOUSE : HandType::THREE_KIND;
+        case 2: return second == 2 ? HandType::TWO_PAIR : HandType::ONE_PAIR;
+        default: return HandType::SADNESS;
+    }
+}
+
+// every way to split 'left' cards into groups of at most 'max_group', biggest first.
+constexpr void addShapes(Table& table, int jokers, int left, int max_group, int largest, int second, int pairs) {
+    if (left == 0) {
+        table[jokers][pairs] = typeOf(largest + jokers, second);
+        return;
+    }
+    for (int group = std::min(left, max_group); group >= 1; --group) {
+        addShapes(table, jokers, left - group, group,
+                  largest == 0 ? group : largest, largest == 0 ? 0 : std::max(second, group), pairs + group * (group - 1) / 2);
+    }
+}
+
+constexpr Table makeTable() {
+    Table table {};
+    for (int jokers = 0; jokers <= 5; ++jokers) addShapes(table, jokers, 5 - jokers, 5, 0, 0, 0);
+    return table;
+}
+
+constexpr Table TABLE = makeTable();
+
+static_assert(TABLE[0][4] == HandType::FULL_HOUSE && TABLE[0][3] == HandType::THREE_KIND);
+static_assert(TABLE[1][2] == HandType::FULL_HOUSE && TABLE[1][1] == HandType::THREE_KIND && TABLE[2][0] == HandType::THREE_KIND);
+
+// 10 comparisons and a load.
+constexpr HandType classify(const std::array<int8_t, 5>& cards) {
+    int jokers = 0;
+    int pairs = 0;
+    for (int i = 0; i < 5; ++i) {
+        jokers += cards[i] == JOKER_VALUE;
+        for (int k = i + 1; k < 5; ++k) pairs += cards[i] == cards[k] && cards[i] != JOKER_VALUE;
+    }
+    return TABLE[jokers][pairs];
+}
+
+}
+
 struct Hand {
     int wager;
     std::array<int8_t, 5> cards;
@@ -29,37 +94,22 @@ struct Hand {
 
     Hand() { ; } // NOLINT(cppcoreguidelines-pro-type-member-init) -- intentionally uninitiliazed. We want this when we copy from one vector to the other.
 
-    explicit Hand(const std::string& input, bool use_jokers) : wager(0), cards({}) {
-        // will hilariously break if a non-single-digit or TJQKA card exists.
-        std::istringstream scanner(input);
-
-        auto char_to_card_value = [use_jokers](int c) -> int8_t {
-            switch(c) {
-                case 'T': return 10;
-                case 'J': return use_jokers ? JOKER_VALUE : 11;
-                case 'Q': return 12;
-                case 'K': return 13;
-                case 'A': return 14;
-                default: return static_cast<int8_t>(c - '0');
-            }
-        };
-
+    // card values are 2-14, or JOKER_VALUE for a joker.
+    Hand(const std::array<int8_t, 5>& from, int wager) : wager(wager), cards(from) {
+#if LOOKUP_TABLE_CLASSIFIER
+        power = Classifier::classify(cards);
+#else
         // used for calculations of card type, later. Counts # of occurences of a card in the hand.
         // Index maps to card number directly.
         // Undefined value in index 0. (There are no cards with value 0)
         std::array<int, 15> buckets {};
-        // assign cards
         for (auto& card : cards) {
-            card = char_to_card_value(scanner.get());
-
             if (card == JOKER_VALUE) { // a joker can be anything, so increment every card...
                 for (auto& bucket : buckets) { bucket++; }
             } else {
                 buckets[card]++;
             }
         }
-        // assign wager, do this after card reading as the scanner needs to be past the card description!
-        scanner >> wager;
 
         // calculate card type. Count occurence numbers. e.g. 2x2 -> two_pair. 3 & 2 -> full_house. Need to count 0 to simplify the mapping.
         std::array<int, 6> counts {};
@@ -78,6 +128,17 @@ struct Hand {
         } else {
             power = HandType::SADNESS;
         }
+#endif
+    }
+
+    /**
+     * The type and then the cards, 4 bits each, in one integer: comparing keys is comparing hands. Only the low 23 bits are used.
+     * [type / 10 : 3][card 0 : 4][card 1 : 4][card 2 : 4][card 3 : 4][card 4 : 4]
+     */
+    [[nodiscard]] uint32_t key() const {
+        uint32_t k = static_cast<uint32_t>(power) / 10;
+        for (auto card : cards) k = k << 4 | static_cast<uint32_t>(card);
+        return k;
     }
 
 private:
@@ -115,20 +176,6 @@ private:
     }
 };
 
-bool operator<(const Hand& a, const Hand& b) {
-    if (a.power != b.power) {
-        return a.power < b.power;
-    } else {
-        int i = 0;
-        while (a.cards[i] == b.cards[i]) {
-            ++i;
-        }
-
-        // i == size implies hands are exactly equal.
-        return i != a.cards.size() && a.cards[i] < b.cards[i];
-    }
-}
-
 std::ostream& operator<<(std::ostream& os, const Hand& h) {
     os  << "Hand {\n\t"
         << "cards: "
@@ -147,17 +194,36 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+    // Every line is read once, and turns into both hands: with J as a jack (part 1) and as a joker (part 2).
+    void parse(std::istream& input) override {
+        auto char_to_card_value = [](char c, bool use_jokers) -> int8_t {
+            switch(c) {
+                case 'T': return 10;
+                case 'J': return use_jokers ? JOKER_VALUE : 11;
+                case 'Q': return 12;
+                case 'K': return 13;
+                case 'A': return 14;
+                default: return static_cast<int8_t>(c - '0');
+            }
+        };
+
         std::string line;
         while (std::getline(input, line)) {
-            Hand h(line, false);
-            hands_1.emplace_back(h);
-        }
-        input.clear();
-        input.seekg(0);
-        while (std::getline(input, line)) {
-            Hand h(line, true);
-            hands_2.emplace_back(h);
+            if (! line.empty() && line.back() == '\r') line.pop_back();
+            if (line.size() < 7) continue; // "CCCCC W"
+
+            std::array<int8_t, 5> jacks {};
+            std::array<int8_t, 5> jokers {};
+            for (int i = 0; i < 5; ++i) {
+                jacks[i] = char_to_card_value(line[i], false);
+                jokers[i] = char_to_card_value(line[i], true);
+            }
+
+            int wager = 0;
+            for (size_t i = 6; i < line.size() && line[i] >= '0' && line[i] <= '9'; ++i) wager = wager * 10 + (line[i] - '0');
+
+            hands_1.push_back(packed(Hand(jacks, wager)));
+            hands_2.push_back(packed(Hand(jokers, wager)));
         }
     }
 
@@ -169,16 +235,23 @@ public:
         solveProblem(hands_2);
     }
 
-    // copies the vector so that it can be sorted. It sucks there is no std::sort that creates a new vector.
-    void solveProblem(const std::vector<Hand>& hands) const {
-        std::vector<Hand> sorted_hands(hands.size());
-        std::partial_sort_copy(hands.begin(), hands.end(), sorted_hands.begin(), sorted_hands.end());
+    // copies the hands so that they can be sorted. The key is in the upper half, so sorting on that is the ranking.
+    // LSD radix sort over the 3 bytes of the key: linear time, and only two flat buffers.
+    void solveProblem(const std::vector<uint64_t>& hands) const {
+        std::vector<uint64_t> sorted_hands(hands);
+        std::vector<uint64_t> scratch(hands.size());
+        for (int shift = 32; shift < 32 + 24; shift += 8) {
+            std::array<size_t, 257> offsets {};
+            for (uint64_t h : sorted_hands) offsets[((h >> shift) & 0xFF) + 1]++;
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+            for (uint64_t h : sorted_hands) scratch[offsets[(h >> shift) & 0xFF]++] = h;
+            std::swap(sorted_hands, scratch);
+        }
 
-        int rank_counter = 1;
-        auto accumulator = [&rank_counter](int64_t s, const Hand& c) -> int64_t {
-            return s + (rank_counter++) * c.wager;
-        };
-        int64_t rank_times_wager = std::accumulate(sorted_hands.begin(), sorted_hands.end(), 0LL, accumulator);
+        int64_t rank_times_wager = 0;
+        for (size_t i = 0; i < sorted_hands.size(); ++i) {
+            rank_times_wager += static_cast<int64_t>(i + 1) * static_cast<uint32_t>(sorted_hands[i]);
+        }
         reportSolution(rank_times_wager);
     }
 
@@ -188,10 +261,15 @@ public:
     }
 
 private:
-    std::vector<Hand> hands_1;
-    std::vector<Hand> hands_2;
+    std::vector<uint64_t> hands_1; // key << 32 | wager
+    std::vector<uint64_t> hands_2;
+
+    static uint64_t packed(const Hand& h) {
+        return static_cast<uint64_t>(h.key()) << 32 | static_cast<uint32_t>(h.wager);
+    }
 };
 
 }
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef LOOKUP_TABLE_CLASSIFIER
\ No newline at end of file
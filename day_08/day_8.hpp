@@ -1,191 +1,394 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iostream>
-#include <memory>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 8
 
-NAMESPACE_DEF(DAY) {
+#define GENERAL_GHOSTS true // v2 makes no assumptions about the input. Tails, several Z's per cycle, it's all fine.
+#define USE_TASK_POOL true // the passes of all nodes, and every ghost, are worked out on the work-stealing pool.
 
-class NetworkNode;
-using NetworkNodePtr = std::shared_ptr<NetworkNode>;
+NAMESPACE_DEF(DAY) {
 
 enum class Direction : bool {
     LEFT,
     RIGHT
 };
 
+// The L/R string, one bit per instruction. 1 is right.
 class Instructions {
-    std::istringstream instructionScanner;
-public:
+    std::vector<uint64_t> bits;
+    size_t length = 0;
 
-    Direction getDirection() {
-        int c = instructionScanner.get();
-
-        if (c == EOF) { // It's rewind time!
-            instructionScanner.clear();
-            instructionScanner.seekg(0);
-            c = instructionScanner.get();
+public:
+    explicit Instructions(std::string_view from) : bits((from.size() + 63) / 64, 0), length(from.size()) {
+        for (size_t i = 0; i < from.size(); ++i) {
+            switch(from[i]) {
+                case 'L': break;
+                case 'R': bits[i / 64] |= uint64_t{1} << (i % 64); break;
+                default:
+                    throw std::logic_error(std::string("Illegal char in directions ") + from[i]);
+            }
         }
-
-        switch(c) {
-            case 'L': return Direction::LEFT;
-            case 'R': return Direction::RIGHT;
-            default:
-                throw std::logic_error(std::string("Illegal char in directions ") + static_cast<char>(c));
+        if (length == 0) {
+            throw std::logic_error("No directions");
         }
     }
 
-    explicit Instructions(const std::string& from) {
-        instructionScanner.str(from);
-    }
+    Instructions() = default;
 
-    explicit Instructions() = delete;
-};
+    [[nodiscard]] size_t size() const { return length; }
 
-class NetworkNode {
-    NetworkNodePtr left_;
-    NetworkNodePtr right_;
+    [[nodiscard]] Direction operator[](size_t i) const {
+        return static_cast<Direction>((bits[i / 64] >> (i % 64)) & 1);
+    }
+};
 
+/**
+ * Labels are three digits or capital letters (the examples use 11A and 22Z), so a label is its base 36 number: 36^3 = 46656 fits in 16 bits.
+ * The nodes are then two flat arrays indexed by label, one per direction. A step is two loads: the instruction bit and the next node.
+ */
+class Network {
 public:
-    const std::string label;
+    using Node = uint16_t;
+    static constexpr int BASE = 36;
+    static constexpr int N_LABELS = BASE * BASE * BASE;
+
+    // 0-9 are 0-9, A-Z are 10-35. -1 for anything else.
+    static constexpr int digit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+        return -1;
+    }
 
-    NetworkNode() = delete;
-    explicit NetworkNode(std::string lbl) : label(std::move(lbl)) {}
+    static constexpr char character(int d) { return static_cast<char>(d < 10 ? '0' + d : 'A' + d - 10); }
 
-    void validate () const {
-        if (left_ == nullptr || right_ == nullptr) {
-            throw std::logic_error("Invalid nodePtr in " + label);
+    static Node encode(std::string_view label) {
+        if (label.size() != 3) {
+            throw std::logic_error("Labels are 3 characters, got '" + std::string(label) + "'");
         }
+        int node = 0;
+        for (char c : label) {
+            if (digit(c) < 0) {
+                throw std::logic_error("Labels are digits and capital letters, got '" + std::string(label) + "'");
+            }
+            node = node * BASE + digit(c);
+        }
+        return static_cast<Node>(node);
     }
 
-    [[nodiscard]] const NetworkNode * left() const {
-        return left_.get();
+    static std::string decode(Node node) {
+        return { character(node / (BASE * BASE)), character(node / BASE % BASE), character(node % BASE) };
     }
 
-    [[nodiscard]] const NetworkNode * right() const {
-        return right_.get();
+    static bool endsWith(Node node, char c) { return node % BASE == digit(c); }
+
+    Network() : next { std::vector<Node>(N_LABELS), std::vector<Node>(N_LABELS) }, present(N_LABELS, false) {}
+
+    void add_node(Node node, Node left, Node right) {
+        next[0][node] = left;
+        next[1][node] = right;
+        present[node] = true;
+        nodes.push_back(node);
     }
 
-    void set_left(NetworkNodePtr l) {
-        left_ = std::move(l);
+    // every node that is pointed to should also be there.
+    void validate() const {
+        for (Node node : nodes) {
+            if (! present[next[0][node]] || ! present[next[1][node]]) {
+                throw std::logic_error("Node labeled " + decode(node) + " Has illegal labels: " + decode(next[0][node]) + " or " + decode(next[1][node]));
+            }
+        }
     }
-    void set_right(NetworkNodePtr r) {
-        right_ = std::move(r);
+
+    [[nodiscard]] bool contains(Node node) const { return present[node]; }
+
+    [[nodiscard]] Node step(Node from, Direction direction) const {
+        return next[static_cast<size_t>(direction)][from];
     }
-};
 
-class Network {
-    std::map<std::string, NetworkNodePtr> network;
+    void get_nodes_ending_with(char c, std::vector<Node>& out) const {
+        for (Node node : nodes) {
+            if (endsWith(node, c)) out.push_back(node);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return nodes.size(); }
+    [[nodiscard]] const std::vector<Node>& labels() const { return nodes; }
 
+private:
     friend std::ostream& operator<<(std::ostream& os, const Network& n);
 
+    std::array<std::vector<Node>, 2> next; // [direction][node]
+    std::vector<bool> present;
+    std::vector<Node> nodes; // in input order.
+};
+
+std::ostream& operator<<(std::ostream& os, const Network& n) {
+    os  << "Network with (" << n.size() << ") nodes: {\n";
+    for (auto node : n.nodes) {
+        os << "\t'" << Network::decode(node) << "': '" << Network::decode(n.next[0][node]) << "', '" << Network::decode(n.next[1][node]) << "'\n";
+    }
+    os << "}";
+    return os;
+}
+
+/**
+ * A pass is all instructions once. After a pass, the instruction pointer is back at the start,
+ * so where a pass ends only depends on the node it started on. This table has that for the nodes that a pass can start on,
+ * coming from the given starts, and the steps into the pass at which it stood on a Z node.
+ * Those nodes are found breadth first, and numbered in that order (their slot), so everything else is a flat array.
+ * Passes compose: lift() adds levels of 2^k passes, so positionAfter() takes about log2(steps) loads, and one pass at most.
+ */
+class PassTable {
 public:
-    void add_node(NetworkNodePtr&& node) {
-        network.emplace(node->label, node);
+    using Node = Network::Node;
+
+    PassTable(const Network& network, const Instructions& instructions, const std::vector<Node>& starts)
+        : network(&network), instructions(&instructions), slots(Network::N_LABELS, -1) {
+        auto reach = [this](Node node) {
+            if (slots[node] >= 0) return;
+            slots[node] = static_cast<int32_t>(reached.size());
+            reached.push_back(node);
+        };
+        for (Node start : starts) reach(start);
+
+        // one round per distance from the starts, the passes of a round are independent.
+        for (size_t begin = 0; begin < reached.size(); ) {
+            const size_t end = reached.size();
+            ends.resize(end);
+            zHits.resize(end);
+            auto walk = [&](int64_t index) {
+                const size_t slot = begin + index;
+                Node current = reached[slot];
+                for (size_t i = 0; i < instructions.size(); ) {
+                    // nothing but steps until the next Z, so the loop keeps everything in registers.
+                    do {
+                        current = network.step(current, instructions[i++]);
+                    } while (i < instructions.size() && ! Network::endsWith(current, 'Z'));
+                    if (Network::endsWith(current, 'Z')) zHits[slot].push_back(static_cast<int64_t>(i));
+                }
+                ends[slot] = current;
+            };
+#if USE_TASK_POOL
+            parallelFor(0, static_cast<int64_t>(end - begin), walk, NODES_PER_TASK);
+#else
+            for (size_t i = 0; i < end - begin; ++i) walk(static_cast<int64_t>(i));
+#endif
+            for (size_t slot = begin; slot < end; ++slot) reach(ends[slot]);
+            begin = end;
+        }
+
+        jumps.emplace_back(reached.size());
+        for (size_t slot = 0; slot < reached.size(); ++slot) jumps[0][slot] = slots[ends[slot]];
+    }
+
+    [[nodiscard]] int64_t length() const { return static_cast<int64_t>(instructions->size()); }
+    [[nodiscard]] size_t size() const { return reached.size(); }
+    [[nodiscard]] int32_t slot(Node node) const { return slots[node]; } // -1 when not reachable from the starts.
+    [[nodiscard]] Node after(Node from) const { return ends[slots[from]]; }
+    [[nodiscard]] const std::vector<int64_t>& hits(Node from) const { return zHits[slots[from]]; } // 1..length(), ascending.
+
+    // enough levels that positionAfter() can take 'steps'.
+    void lift(int64_t steps) {
+        while ((int64_t{1} << (jumps.size() - 1)) <= steps / length()) {
+            const auto& last = jumps.back();
+            std::vector<int32_t> doubled(last.size());
+            for (size_t slot = 0; slot < last.size(); ++slot) doubled[slot] = last[last[slot]];
+            jumps.push_back(std::move(doubled));
+        }
     }
 
-    [[nodiscard]] const NetworkNode * get_node(const std::string& lbl) const {
-        auto iter = std::find_if(network.begin(), network.end(), [&lbl](auto& kvp) {
-            return kvp.first == lbl;
-        });
+    [[nodiscard]] Node positionAfter(Node from, int64_t steps) const {
+        int64_t passes = steps / length();
+        if (passes >> (jumps.size() - 1) > 1) {
+            throw std::logic_error("Pass table was not lifted far enough for " + std::to_string(steps) + " steps");
+        }
+        int32_t at = slots[from];
+        for (size_t k = 0; passes != 0; ++k, passes >>= 1) {
+            if (passes & 1) at = jumps[k][at];
+        }
+        from = reached[at];
+        for (int64_t i = 0; i < steps % length(); ++i) {
+            from = network->step(from, (*instructions)[i]);
+        }
+        return from;
+    }
 
-        if (iter == network.end()) {
-            throw std::logic_error("Label " + lbl + " Was requested, but not present in the Network.");
+private:
+    static constexpr int64_t NODES_PER_TASK = 64;
+
+    const Network * network;
+    const Instructions * instructions;
+    std::vector<int32_t> slots; // [node]
+    std::vector<Node> reached; // [slot]
+    std::vector<Node> ends; // [slot] -> where its pass ends.
+    std::vector<std::vector<int32_t>> jumps; // [k][slot] -> the slot that 2^k passes from there end up on.
+    std::vector<std::vector<int64_t>> zHits; // [slot]
+};
+
+/**
+ * When a ghost is on a Z node, for a ghost that may walk into its cycle after a while.
+ * The states are (node, instruction pointer), but only those at the start of a pass are needed: every pass is a function of its first node.
+ * So the passes go through the first nodes n, pass(n), pass(pass(n)), ... which repeat after at most one pass per node.
+ */
+struct Ghost {
+    int64_t tail_end; // passes before the cycle, in steps. Until here, there are just the hits.
+    int64_t period; // after that, this repeats.
+    std::vector<int64_t> tail_hits; // in (0, tail_end]
+    std::vector<int64_t> cycle_hits; // in (tail_end, tail_end + period]
+
+    Ghost(const PassTable& passes, Network::Node start) {
+        std::vector<int32_t> first_seen(passes.size(), -1); // by slot
+        std::vector<int64_t> hit_times;
+
+        int32_t pass = 0;
+        Network::Node node = start;
+        for (; first_seen[passes.slot(node)] < 0; ++pass) {
+            first_seen[passes.slot(node)] = pass;
+            for (int64_t hit : passes.hits(node)) hit_times.push_back(pass * passes.length() + hit);
+            node = passes.after(node);
         }
 
-        return iter->second.get();
+        tail_end = first_seen[passes.slot(node)] * passes.length();
+        period = (pass - first_seen[passes.slot(node)]) * passes.length();
+        for (int64_t t : hit_times) (t <= tail_end ? tail_hits : cycle_hits).push_back(t);
     }
 
-    void get_nodes_ending_with(char c, std::vector<const NetworkNode *>& out) const {
-        std::for_each(network.begin(), network.end(), [&out, c](auto& pair) {
-            if (pair.first.back() == c) {
-                out.push_back(pair.second.get());
-            }
-        });
+    [[nodiscard]] bool at(int64_t t) const {
+        if (t <= tail_end) return std::binary_search(tail_hits.begin(), tail_hits.end(), t);
+        int64_t folded = tail_end + 1 + (t - tail_end - 1) % period;
+        return std::binary_search(cycle_hits.begin(), cycle_hits.end(), folded);
     }
 };
 
-std::ostream& operator<<(std::ostream& os, const Network& n) {
-    os  << "Network with (" << n.network.size() << ") nodes: {\n";
-    for (auto& item : n.network) {
-        os << "\t'" << item.first << "': '" << item.second->left()->label << "', '" << item.second->right()->label << "'\n";
+/**
+ * The first step (> 0) at which all ghosts are on a Z node.
+ * Up to the longest tail, the hits of the first ghost are tried on the others.
+ * After that every ghost is periodic, and the times it is on a Z are a few residues modulo its period. Those are merged with the CRT.
+ */
+constexpr size_t MAX_RESIDUES = 1 << 20;
+
+inline int64_t firstTimeAllOnZ(const std::vector<Ghost>& ghosts) {
+    using int128 = __int128;
+    if (ghosts.empty()) throw std::logic_error("No ghosts");
+
+    int64_t longest_tail = 0;
+    for (const auto& g : ghosts) longest_tail = std::max(longest_tail, g.tail_end);
+
+    auto everyone_at = [&](int64_t t) { return std::all_of(ghosts.begin() + 1, ghosts.end(), [t](const Ghost& g) { return g.at(t); }); };
+    const Ghost& first = ghosts[0];
+    for (int64_t t : first.tail_hits) {
+        if (everyone_at(t)) return t;
     }
-    os << "}";
-    return os;
+    for (int64_t round = 0; ! first.cycle_hits.empty() && first.cycle_hits[0] + round * first.period <= longest_tail; ++round) {
+        for (int64_t t : first.cycle_hits) {
+            if (t + round * first.period <= longest_tail && everyone_at(t + round * first.period)) return t + round * first.period;
+        }
+    }
+
+    // x = a (mod m) and x = b (mod n). Sets 'a' and 'm' to the combination and returns true, unless there is none.
+    auto crt = [](int128& a, int128& m, int128 b, int128 n) {
+        int128 old_r = m, r = n, old_s = 1, s = 0; // extended euclid, old_s * m = gcd (mod n)
+        while (r != 0) {
+            int128 q = old_r / r;
+            std::tie(old_r, r) = std::make_pair(r, old_r - q * r);
+            std::tie(old_s, s) = std::make_pair(s, old_s - q * s);
+        }
+        int128 g = old_r;
+        if ((b - a) % g != 0) return false;
+        int128 step = n / g;
+        int128 k = ((b - a) / g % step * (old_s % step)) % step;
+        if (k < 0) k += step;
+        a += m * k;
+        m *= step;
+        return true;
+    };
+
+    std::vector<int128> residues { 0 };
+    int128 modulus = 1;
+    for (const auto& g : ghosts) {
+        std::vector<int128> merged;
+        int128 merged_modulus = modulus;
+        for (int128 a : residues) {
+            for (int64_t hit : g.cycle_hits) {
+                int128 x = a;
+                int128 m = modulus;
+                if (crt(x, m, hit % g.period, g.period)) {
+                    merged.push_back(x);
+                    merged_modulus = m;
+                }
+            }
+        }
+        std::sort(merged.begin(), merged.end());
+        merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+        residues = std::move(merged);
+        modulus = merged_modulus;
+
+        if (residues.empty()) throw std::logic_error("The ghosts are never all on a Z node at the same time");
+        if (modulus > std::numeric_limits<int64_t>::max() || residues.size() > MAX_RESIDUES) {
+            throw std::logic_error("The ghost cycles are too long, or have too many Z nodes, to combine");
+        }
+    }
+
+    int128 best = -1;
+    for (int128 r : residues) {
+        int128 t = r + (longest_tail + 1 - r + modulus - 1) / modulus * modulus; // the first one past all tails.
+        if (best < 0 || t < best) best = t;
+    }
+    if (best > std::numeric_limits<int64_t>::max()) throw std::logic_error("Ghost answer does not fit 64 bits");
+    return static_cast<int64_t>(best);
 }
 
 CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+    void parse(std::istream& input) override {
         std::string line;
         std::getline(input, line);
-        instructions_string = line;
+        if (! line.empty() && line.back() == '\r') line.pop_back();
+        instructions = Instructions(line);
 
         std::getline(input, line); // blank line
 
-        std::vector<std::pair<NetworkNodePtr, std::pair<std::string, std::string>>> nodelets;
         while (std::getline(input, line)) {
+            if (line.size() < 16) continue;
             // format: X = (Y, Z)
-            auto a = line.substr(0, 3);
-            auto b = line.substr(7, 3);
-            auto c = line.substr(12, 3);
-
-            nodelets.push_back({ std::make_shared<NetworkNode>(a), {b, c} });
-        }
-
-        /**
-         * Curried Predicate function for finding a node matching the 'seeking' parameter.
-         * The result of calling the (outer) function should be used with std::find_if or as a similar predicate functor.
-         */
-        auto search_predicate = [](const std::string& seeking) {
-            return [&seeking](auto& nodelet_item) {
-                return nodelet_item.first->label == seeking;
-            };
-        };
-
-        for (const auto& [node, label_pair] : nodelets) {
-            auto a = std::find_if(nodelets.begin(), nodelets.end(), search_predicate(label_pair.first));
-            auto b = std::find_if(nodelets.begin(), nodelets.end(), search_predicate(label_pair.second));
-
-            if (nodelets.end() == a || nodelets.end() == b) {
-                throw std::logic_error("Node labeled " + node->label +  " Has illegal labels: " + label_pair.first + " or " + label_pair.second);
-            }
-
-            node->set_left(a->first);
-            node->set_right(b->first);
+            std::string_view view(line);
+            network.add_node(Network::encode(view.substr(0, 3)), Network::encode(view.substr(7, 3)), Network::encode(view.substr(12, 3)));
         }
 
-        std::for_each(nodelets.begin(), nodelets.end(), [this](auto& nodelet) {
-            nodelet.first->validate();
-            network.add_node(std::move(nodelet.first));
-        });
+        network.validate();
     }
 
     void v1() const override {
-        Instructions instructions(instructions_string);
-
-        int stepCount = 0;
-        auto* current = network.get_node("AAA");
-        while (current->label != "ZZZ") {
-            stepCount ++; // step taken, where do we end up?
-            auto direction = instructions.getDirection();
-            switch(direction) {
-                case Direction::LEFT:
-                    current = current->left();
-                    break;
-                case Direction::RIGHT:
-                    current = current->right();
-                    break;
-                default:
-                    throw std::logic_error("Literally how, this enum is a bool.");
-            }
+        const auto start = Network::encode("AAA");
+        const auto end = Network::encode("ZZZ");
+        if (! network.contains(start)) {
+            throw std::logic_error("Label AAA Was requested, but not present in the Network.");
+        }
+
+        int64_t stepCount = 0;
+        size_t i = 0;
+        for (auto current = start; current != end; ++stepCount) {
+            current = network.step(current, instructions[i]);
+            if (++i == instructions.size()) i = 0;
         }
 
         reportSolution(stepCount);
@@ -193,61 +396,72 @@ public:
 
     void v2() const override {
 
-        std::vector<const NetworkNode *> starts;
+        std::vector<Network::Node> starts;
         network.get_nodes_ending_with('A', starts);
 
+#if GENERAL_GHOSTS
+        PassTable passes(network, instructions, starts);
+
+        std::vector<std::optional<Ghost>> ghosts(starts.size());
+        auto follow = [&](int64_t i) { ghosts[i].emplace(passes, starts[i]); };
+#if USE_TASK_POOL
+        parallelFor(0, static_cast<int64_t>(starts.size()), follow, 1);
+#else
+        for (size_t i = 0; i < starts.size(); ++i) follow(static_cast<int64_t>(i));
+#endif
+
+        std::vector<Ghost> found;
+        for (auto& g : ghosts) found.push_back(std::move(*g));
+        int64_t steps = firstTimeAllOnZ(found);
+
+        // and to be sure, jump every ghost there.
+        passes.lift(steps);
+        for (auto start : starts) {
+            if (! Network::endsWith(passes.positionAfter(start, steps), 'Z')) {
+                throw std::logic_error("Ghost from " + Network::decode(start) + " is not on a Z node after " + std::to_string(steps) + " steps");
+            }
+        }
+
+        reportSolution(steps);
+#else
         // This solution assumes that nodes immediately start on their cycle,
         // And that a cycle is as simple as possible: just one Z node per cycle.
         // This enables us to compute the LCM of all cycles.
-        // A more general solution exists (LCM computation in linear time),
-        // For when there is a 'tail' of nodes before a cycle is entered.
-        // At commit 4c3c25a027f1759cabaeb6ac372d042bdcfbc4bf.
-        // Even more general solutions (Multiple Z nodes per cycle) were not made.
-        int64_t cycles_lcm;
-        {
-            int first_node_cycle_count = 0;
-            Instructions i(instructions_string);
-            findNextZ(i, starts[0], first_node_cycle_count);
-            cycles_lcm = first_node_cycle_count;
-        }
-
-        for (auto iter = starts.begin() + 1; iter != starts.end(); ++iter) {
-            int steps_taken = 0;
-            Instructions i(instructions_string);
-            findNextZ(i, *iter, steps_taken);
-            cycles_lcm = std::lcm(cycles_lcm, steps_taken);
+        int64_t cycles_lcm = 1;
+        for (auto start : starts) {
+            cycles_lcm = std::lcm(cycles_lcm, stepsToNextZ(start));
         }
 
         reportSolution(cycles_lcm);
+#endif
     }
 
     void parseBenchReset() override {
-        instructions_string.clear();
+        instructions = Instructions();
         network = Network();
     }
 
 private:
-    std::string instructions_string;
+    Instructions instructions;
     Network network;
 
     // problem 2 helper func
-    static const NetworkNode * findNextZ(Instructions& i, const NetworkNode * from, int& stepCount) {
+    [[nodiscard]] int64_t stepsToNextZ(Network::Node from) const {
+        int64_t stepCount = 0;
+        size_t i = 0;
         auto current = from;
         do {
             stepCount++;
-            auto dir = i.getDirection();
-            if (dir == Direction::LEFT) {
-                current = current->left();
-            } else {
-                current = current->right();
-            }
-            // std::cout << "\t\tstep " << stepCount << " go " << (dir == Direction::LEFT ? 'L' : 'R') << " to " << current->label << "\n";
-        } while (current->label.back() != 'Z');
+            current = network.step(current, instructions[i]);
+            if (++i == instructions.size()) i = 0;
+        } while (! Network::endsWith(current, 'Z'));
 
-        return current;
+        return stepCount;
     }
 };
 
 }
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef GENERAL_GHOSTS
+#undef USE_TASK_POOL
\ No newline at end of file
@@ -1,12 +1,19 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
+#include "day_9_binomial.hpp"
+#include "day_9_wide.hpp"
 
 #define DAY 9
 
+#define BINOMIAL_EXTRAPOLATION true // every sequence is a dot product with precomputed binomial coefficients. No pyramids at all.
+#define WIDE_TOTAL_CHECK false // v1 first solves 300 sequences whose total only fits 128 bits, and throws if that comes out wrong.
 #define DO_LAZY_PYRAMID_INTERPOLATION true
 #define DO_ERROR_CHECKS false // i.e. indexing out of array bounds.
 
@@ -69,7 +76,96 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream& input) override {
+#if BINOMIAL_EXTRAPOLATION
+    void parse(std::istream& input) override {
+        std::map<int, std::vector<int64_t>> rows_by_length; // sequences of one length, one after another.
+        std::vector<int64_t> sequence;
+        std::string line;
+        while(std::getline(input, line)) {
+            sequence.clear();
+            for (size_t i = 0; i < line.size(); ) {
+                if (line[i] != '-' && (line[i] < '0' || line[i] > '9')) { ++i; continue; }
+                bool negative = line[i] == '-';
+                if (negative) ++i;
+                int64_t y = 0;
+                for (; i < line.size() && line[i] >= '0' && line[i] <= '9'; ++i) y = y * 10 + (line[i] - '0');
+                sequence.push_back(negative ? -y : y);
+            }
+            if (sequence.empty()) continue;
+
+            // the matrix is all 64 bit, anything that might not fit is done on its own in a wider type.
+            auto width = Wide::widthFor(sequence);
+            if (width != Wide::Width::INT64) {
+                wide.push_back({ width, sequence });
+                continue;
+            }
+
+            auto& rows = rows_by_length[static_cast<int>(sequence.size())];
+            rows.insert(rows.end(), sequence.begin(), sequence.end());
+        }
+
+        for (const auto& [length, rows] : rows_by_length) {
+            matrices.emplace_back(length);
+            matrices.back().setRows(rows);
+        }
+    }
+
+    void v1() const override {
+#if WIDE_TOTAL_CHECK
+        checkWideTotal();
+#endif
+        solveProblem(true);
+    }
+
+    void v2() const override {
+        solveProblem(false);
+    }
+
+    [[nodiscard]] Wide::int128 total(bool forward) const {
+        Wide::Checked result; // each sequence fits, their sum might still not.
+        for (const auto& m : matrices) result = result + m.extrapolateSum(forward);
+        for (const auto& w : wide) result = result + Wide::extrapolate(w.values, forward, w.width);
+        return result.value;
+    }
+
+    void solveProblem(bool forward) const {
+        Wide::int128 result = total(forward);
+        if (result >= std::numeric_limits<int64_t>::min() && result <= std::numeric_limits<int64_t>::max()) {
+            reportSolution(static_cast<int64_t>(result));
+        } else {
+            reportSolution(Wide::toString(result));
+        }
+    }
+
+    void parseBenchReset() override {
+        matrices.clear();
+        wide.clear();
+    }
+
+private:
+    // 2^55 fits the 64 bit matrix, 300 of them do not fit int64.
+    static void checkWideTotal() {
+        std::string lines;
+        for (int i = 0; i < 300; ++i) lines += "36028797018963968 36028797018963968 36028797018963968\n";
+        std::istringstream input(lines);
+
+        Day9 check;
+        check.parse(input);
+        const Wide::int128 expected = static_cast<Wide::int128>(300) << 55;
+        if (check.total(true) != expected || check.total(false) != expected) {
+            throw std::logic_error("Sequence totals wrap: expected " + Wide::toString(expected) + ", got " + Wide::toString(check.total(true)));
+        }
+    }
+
+    struct WideSequence {
+        Wide::Width width;
+        std::vector<int64_t> values;
+    };
+
+    std::vector<Binomial::Matrix> matrices; // one per sequence length.
+    std::vector<WideSequence> wide;
+#else
+    void parse(std::istream& input) override {
         std::string line;
         while(std::getline(input, line)) {
             std::istringstream s(line);
@@ -113,6 +209,7 @@ public:
 
 private:
     std::vector<std::vector<int>> data;
+#endif
 
 #if DO_LAZY_PYRAMID_INTERPOLATION
     template<bool LeftEdge, int N, typename T>
@@ -263,5 +360,7 @@ std::ostream &operator<<(std::ostream & os, const Pyramid<T, N> &p) {
 
 }
 #undef DAY
+#undef BINOMIAL_EXTRAPOLATION
+#undef WIDE_TOTAL_CHECK
 #undef DO_LAZY_PYRAMID_INTERPOLATION
 #undef DO_ERROR_CHECKS
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../util/Cpu.hpp"
+
+/**
+ * Day 9 without the pyramid. Differencing n values until the row is constant and summing back up is a polynomial of degree < n,
+ * and the value after it is a fixed mix of the values:
+ *   x[n]  = sum over i of (-1)^(n-1-i) * C(n, i)   * x[i]
+ *   x[-1] = sum over i of (-1)^i       * C(n, i+1) * x[i]
+ * So every sequence length gets its coefficients once, and every sequence is then a dot product.
+ * All sequences of one length are stored column by column, so the dot products of all of them are done at once, 4 lanes at a time.
+ */
+namespace Day9::Binomial {
+
+// 'forward' is the value after the sequence, otherwise the one before it. C(67, 33) no longer fits 64 bits.
+inline std::vector<int64_t> coefficients(int n, bool forward) {
+    if (n < 1 || n > 66) {
+        throw std::logic_error("No 64 bit coefficients for sequences of length " + std::to_string(n));
+    }
+
+    std::vector<int64_t> binomial(n + 1); // C(n, k), built up from C(n, k - 1). The division is exact.
+    binomial[0] = 1;
+    for (int k = 1; k <= n; ++k) {
+        binomial[k] = static_cast<int64_t>(static_cast<__int128>(binomial[k - 1]) * (n - k + 1) / k);
+    }
+
+    std::vector<int64_t> c(n);
+    for (int i = 0; i < n; ++i) {
+        if (forward) {
+            c[i] = (n - 1 - i) % 2 == 0 ? binomial[i] : -binomial[i];
+        } else {
+            c[i] = i % 2 == 0 ? binomial[i + 1] : -binomial[i + 1];
+        }
+    }
+    return c;
+}
+
+constexpr size_t LANES = 4;
+
+/**
+ * Sequences of the same length, value i of sequence s at [i * stride + s].
+ * The stride is padded to whole vectors with all-zero sequences, which extrapolate to 0.
+ */
+class Matrix {
+public:
+    explicit Matrix(int length) : length(length), next(coefficients(length, true)), previous(coefficients(length, false)) {}
+
+    // 'rows' holds whole sequences one after another.
+    void setRows(const std::vector<int64_t>& rows) {
+        count = rows.size() / length;
+        stride = (count + LANES - 1) / LANES * LANES;
+        columns.assign(length * stride, 0);
+
+        fitsInt32 = length <= MAX_INT32_LENGTH;
+        for (size_t s = 0; s < count; ++s) {
+            for (int i = 0; i < length; ++i) {
+                int64_t x = rows[s * length + i];
+                fitsInt32 &= x >= std::numeric_limits<int32_t>::min() && x <= std::numeric_limits<int32_t>::max();
+                columns[i * stride + s] = x;
+            }
+        }
+    }
+
+    [[nodiscard]] int sequenceLength() const { return length; }
+    [[nodiscard]] size_t sequences() const { return count; }
+
+    // out[s] = the value after (or before) sequence s.
+    void extrapolate(bool forward, std::vector<int64_t>& out) const;
+
+    // sum of all of them. Every one fits 64 bits, their sum need not.
+    [[nodiscard]] __int128 extrapolateSum(bool forward) const {
+        std::vector<int64_t> out;
+        extrapolate(forward, out);
+        return std::accumulate(out.begin(), out.end(), __int128{0});
+    }
+
+private:
+    static constexpr int MAX_INT32_LENGTH = 33; // C(33, 16) is the last one that fits 31 bits.
+
+    int length;
+    size_t count = 0;
+    size_t stride = 0;
+    bool fitsInt32 = true; // all values and coefficients fit a signed 32 bit int, so the 32x32 -> 64 multiply can be used.
+    std::vector<int64_t> next;
+    std::vector<int64_t> previous;
+    std::vector<int64_t> columns;
+
+#if AOC_X86 == true
+    __attribute__((target("avx2"))) void extrapolateAvx2(const std::vector<int64_t>& c, std::vector<int64_t>& out) const {
+        for (int i = 0; i < length; ++i) {
+            const __m256i coefficient = _mm256_set1_epi64x(c[i]);
+            const int64_t * row = &columns[i * stride];
+            for (size_t s = 0; s < stride; s += LANES) {
+                __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&out[s]));
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + s));
+                acc = _mm256_add_epi64(acc, _mm256_mul_epi32(coefficient, x));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[s]), acc);
+            }
+        }
+    }
+#endif
+
+    // wraps around like the vector lanes do, the partial sums may overflow even when the answer does not.
+    void extrapolateScalar(const std::vector<int64_t>& c, std::vector<int64_t>& out) const {
+        for (int i = 0; i < length; ++i) {
+            const int64_t * row = &columns[i * stride];
+            for (size_t s = 0; s < stride; ++s) {
+                out[s] = static_cast<int64_t>(static_cast<uint64_t>(out[s]) + static_cast<uint64_t>(c[i]) * static_cast<uint64_t>(row[s]));
+            }
+        }
+    }
+};
+
+inline void Matrix::extrapolate(bool forward, std::vector<int64_t>& out) const {
+    const auto& c = forward ? next : previous;
+    out.assign(stride, 0);
+#if AOC_X86 == true
+    if (fitsInt32 && Cpu::haveAvx2()) {
+        extrapolateAvx2(c, out);
+        out.resize(count);
+        return;
+    }
+#endif
+    extrapolateScalar(c, out);
+    out.resize(count);
+}
+
+} // namespace
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 9, for the embedded input mode. Same answers as Day9, computed from a string_view.
+ */
+namespace Day9::Constexpr {
+
+constexpr int MAX_SEQUENCE = 256; // same bound as the runtime Pyramid.
+
+// The value that comes after the sequence (forward) or before it (! forward).
+constexpr int64_t extrapolate(std::string_view line, bool forward) {
+    std::array<int64_t, MAX_SEQUENCE> values{};
+    int n = 0;
+    ConstexprInput::Numbers numbers{line};
+    int64_t x;
+    while (numbers.next(x)) {
+        if (n == MAX_SEQUENCE) throw std::logic_error("sequence too long");
+        values[n++] = x;
+    }
+
+    // difference in place. Forward sums the last value of every row, backward alternates the sign of the first value.
+    int64_t result = 0;
+    int64_t sign = 1;
+    for (int len = n; len > 0; --len) {
+        result += forward ? values[len - 1] : sign * values[0];
+        sign = -sign;
+
+        bool allZero = true;
+        for (int i = 0; i + 1 < len; ++i) {
+            values[i] = values[i + 1] - values[i];
+            allZero = allZero && values[i] == 0;
+        }
+        if (allZero) break;
+    }
+    return result;
+}
+
+constexpr int64_t solve(std::string_view input, bool forward) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (! line.empty()) sum += extrapolate(line, forward);
+    }
+    return sum;
+}
+
+constexpr int64_t v1(std::string_view input) { return solve(input, true); }
+constexpr int64_t v2(std::string_view input) { return solve(input, false); }
+
+} // namespace
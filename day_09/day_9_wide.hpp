@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Day 9 for sequences whose answers may not fit 64 bits. Row k of the differences is at most 2^k * max|x|,
+ * and the extrapolated value is a sum of one entry per row, so everything stays below 2^n * max|x|.
+ * That bound is known at parse time, and picks the narrowest type that can not overflow:
+ * int64, __int128, or, when not even that is certain, __int128 that checks every operation.
+ * The checked one is still fine for long low degree sequences, their differences go to 0 long before they get big.
+ */
+namespace Day9::Wide {
+
+using int128 = __int128;
+
+// int128 that throws instead of overflowing.
+struct Checked {
+    int128 value = 0;
+
+    Checked() = default;
+    Checked(int128 v) : value(v) {} // NOLINT(google-explicit-constructor) -- so that the template can treat it like a number.
+
+    Checked operator+(Checked o) const {
+        int128 r;
+        if (__builtin_add_overflow(value, o.value, &r)) throw std::logic_error("Sequence extrapolation overflows 128 bits");
+        return r;
+    }
+
+    Checked operator-(Checked o) const {
+        int128 r;
+        if (__builtin_sub_overflow(value, o.value, &r)) throw std::logic_error("Sequence extrapolation overflows 128 bits");
+        return r;
+    }
+
+    Checked operator-() const { return Checked{} - *this; }
+
+    bool operator==(const Checked& o) const = default;
+};
+
+enum class Width : int8_t {
+    INT64,
+    INT128,
+    CHECKED
+};
+
+inline Width widthFor(const std::vector<int64_t>& sequence) {
+    uint64_t largest = 0;
+    for (int64_t x : sequence) largest = std::max(largest, x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x));
+
+    int bound = static_cast<int>(sequence.size()) + (64 - __builtin_clzll(largest | 1)); // bits of 2^n * max|x|
+    if (bound <= 63) return Width::INT64;
+    if (bound <= 127) return Width::INT128;
+    return Width::CHECKED;
+}
+
+// The value after the sequence (forward) or before it (! forward). Differences in place, like the constexpr version.
+template<typename T>
+T extrapolate(const std::vector<int64_t>& sequence, bool forward) {
+    std::vector<T> values(sequence.begin(), sequence.end());
+
+    T result {};
+    bool negate = false;
+    for (size_t len = values.size(); len > 0; --len) {
+        if (forward) {
+            result = result + values[len - 1];
+        } else {
+            result = negate ? result - values[0] : result + values[0];
+            negate = ! negate;
+        }
+
+        bool allZero = true;
+        for (size_t i = 0; i + 1 < len; ++i) {
+            values[i] = values[i + 1] - values[i];
+            allZero = allZero && values[i] == T{};
+        }
+        if (allZero) break;
+    }
+    return result;
+}
+
+inline int128 extrapolate(const std::vector<int64_t>& sequence, bool forward, Width width) {
+    switch (width) {
+        case Width::INT64: return extrapolate<int64_t>(sequence, forward);
+        case Width::INT128: return extrapolate<int128>(sequence, forward);
+        default: return extrapolate<Checked>(sequence, forward).value;
+    }
+}
+
+inline std::string toString(int128 x) {
+    if (x == 0) return "0";
+    bool negative = x < 0;
+    std::string digits;
+    for (; x != 0; x /= 10) digits.push_back(static_cast<char>('0' + (negative ? -(x % 10) : x % 10)));
+    if (negative) digits.push_back('-');
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+} // namespace
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <iostream>
 #include <queue>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 10
 
+#define SCANLINE_PARITY true // v2 counts crossings of the loop along every row, instead of flood filling a maze blown up to 2x.
+#define USE_TASK_POOL true // rows are independent, big mazes are counted in bands of rows on the work-stealing pool.
+
 namespace Day10 {
 
 constexpr uint8_t none_bit = 0;
@@ -135,135 +141,193 @@ std::ostream& operator<<(std::ostream& os, const Maze<T>& m) {
     return os;
 }
 
+/**
+ * The maze as one flat array of connection masks (the *_bit values above), two tiles per byte. Keeps the 1 tile apron of NONE around it.
+ * 140x140 is under 10 KB, and even a 10k x 10k maze is 50 MB.
+ */
+class PipeGrid {
+public:
+    PipeGrid() = default;
+    PipeGrid(int width, int height) : width_(width), height_(height), nibbles((static_cast<size_t>(width) * height + 1) / 2, 0) {}
+
+    [[nodiscard]] uint8_t at(int x, int y) const { return at(static_cast<size_t>(y) * width_ + x); }
+    [[nodiscard]] uint8_t at(size_t i) const { return (nibbles[i / 2] >> (4 * (i % 2))) & 0xF; } // y * width() + x
+
+    void set(int x, int y, uint8_t mask) {
+        size_t i = static_cast<size_t>(y) * width_ + x;
+        nibbles[i / 2] = static_cast<uint8_t>((nibbles[i / 2] & (0xF0 >> (4 * (i % 2)))) | (mask << (4 * (i % 2))));
+    }
+
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int height() const { return height_; }
+
+    // for the exploded maze solution, which wants PipeSegments.
+    [[nodiscard]] Maze<PipeSegment> toMaze() const {
+        Maze<PipeSegment> result;
+        for (int y = 0; y < height_; ++y) {
+            result.emplace_back();
+            for (int x = 0; x < width_; ++x) result.back().emplace_back(static_cast<PipeType>(at(x, y)));
+        }
+        return result;
+    }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> nibbles;
+};
+
+// One bit per tile, rows padded to whole words.
+class Bitplane {
+public:
+    Bitplane(int width, int height) : words((width + 63) / 64), bits(static_cast<size_t>(words) * height, 0) {}
+
+    void set(int x, int y) { bits[static_cast<size_t>(y) * words + x / 64] |= uint64_t{1} << (x % 64); }
+    [[nodiscard]] const uint64_t * row(int y) const { return &bits[static_cast<size_t>(y) * words]; }
+    [[nodiscard]] int wordsPerRow() const { return words; }
+
+private:
+    int words;
+    std::vector<uint64_t> bits;
+};
+
+/**
+ * The walk, as a table. Directions are numbered after their bit: left 0, right 1, up 2, down 3, and the opposite of d is d ^ 1.
+ * EXIT[mask][entry] is the direction a pipe is left in when it is entered from 'entry', or NO_EXIT if that pipe has no such side.
+ */
+namespace Walk {
+
+constexpr uint8_t NO_EXIT = 0xFF;
+
+constexpr std::array<std::array<uint8_t, 4>, 16> makeExitTable() {
+    std::array<std::array<uint8_t, 4>, 16> table {};
+    for (int mask = 0; mask < 16; ++mask) {
+        for (int entry = 0; entry < 4; ++entry) {
+            table[mask][entry] = NO_EXIT;
+            if (std::popcount(static_cast<unsigned>(mask)) == 2 && (mask & (1 << entry)) != 0) {
+                table[mask][entry] = static_cast<uint8_t>(std::countr_zero(static_cast<unsigned>(mask & ~(1 << entry))));
+            }
+        }
+    }
+    return table;
+}
+
+constexpr auto EXIT = makeExitTable();
+
+}
+
 CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
-        int c;
+    void parse(std::istream &input) override {
+        std::vector<std::string> rows;
+        std::string line;
+        while (std::getline(input, line)) {
+            if (! line.empty() && line.back() == '\r') line.pop_back();
+            if (! line.empty()) rows.emplace_back(std::move(line));
+        }
+        if (rows.empty()) {
+            throw std::logic_error("Empty maze");
+        }
+
+        // both off by 1 since we are giving the maze a 1 layer apron.
+        grid = PipeGrid(static_cast<int>(rows[0].size()) + 2, static_cast<int>(rows.size()) + 2);
         int SX = 0;
         int SY = 0;
-
-        int x = 1; // both off by 1 since we are giving the maze a 1 layer apron.
-        int y = 1;
-        maze.emplace_back(); // add the first row of the maze. This shall be filled with a row of nothing, preventing OOB access.
-        maze.emplace_back(); // This is the first row of actual data.
-        maze.back().emplace_back(PipeType::NONE); // start the row with 1x nothing.
-        while ((c = input.get()) != EOF) {
-            auto &mazeRow = maze.back();
-            switch (c) {
-                case '\n':
-                    mazeRow.emplace_back(PipeType::NONE); // end the row with 1x nothing.
-                    y++;
-                    x = 1;
-                    maze.emplace_back(); // new row.
-                    maze.back().emplace_back(PipeType::NONE); // start the row with 1x nothing.
-                    continue; // do not go 'below' the switch, where x is incremented.
-                case '.':
-                    mazeRow.emplace_back(PipeType::NONE);
-                    break; // nothing here.
-                case '-': // leftright
-                    mazeRow.emplace_back(PipeType::LEFTRIGHT);
-                    break;
-                case '|': // updown
-                    mazeRow.emplace_back(PipeType::UPDOWN);
-                    break;
-                case 'J': // leftup
-                    mazeRow.emplace_back(PipeType::LEFTUP);
-                    break;
-                case 'L': // upright
-                    mazeRow.emplace_back(PipeType::UPRIGHT);
-                    break;
-                case 'F': // rightdown
-                    mazeRow.emplace_back(PipeType::RIGHTDOWN);
-                    break;
-                case '7': // downleft
-                    mazeRow.emplace_back(PipeType::DOWNLEFT);
-                    break;
-                case 'S': // starting point, unknown pipe segment.
-                    mazeRow.emplace_back(PipeType::UNKNOWN);
-                    SX = x;
-                    SY = y;
-                    break;
-                default:
-                    throw std::logic_error("Unknown char " + std::string{static_cast<char>(c)});
+        for (int y = 1; y <= static_cast<int>(rows.size()); ++y) {
+            const auto& row = rows[y - 1];
+            if (static_cast<int>(row.size()) + 2 != grid.width()) {
+                throw std::logic_error("Maze rows must all have the same width"); // An 'evenly sized' maze is assumed.
+            }
+            for (int x = 1; x <= static_cast<int>(row.size()); ++x) {
+                char c = row[x - 1];
+                switch (c) {
+                    case '.': break; // nothing here.
+                    case '-': grid.set(x, y, left_bit | right_bit); break;
+                    case '|': grid.set(x, y, up_bit | down_bit); break;
+                    case 'J': grid.set(x, y, left_bit | up_bit); break;
+                    case 'L': grid.set(x, y, up_bit | right_bit); break;
+                    case 'F': grid.set(x, y, right_bit | down_bit); break;
+                    case '7': grid.set(x, y, down_bit | left_bit); break;
+                    case 'S': // starting point, unknown pipe segment.
+                        SX = x;
+                        SY = y;
+                        break;
+                    default:
+                        throw std::logic_error("Unknown char " + std::string{c});
+                }
             }
-            x++;
         }
         if (SX == 0 || SY == 0) {
             throw std::logic_error("S was never assigned."); // S cannot be 0,0 since the perimeter belongs to the apron.
         }
-        // EOF was reached. Add the bottom apron.
-        maze.back().emplace_back(PipeType::NONE); // right side of the final row
-        maze.emplace_back(); // add the bottom row.
-        // Fill the top and bottom apron rows with actual data, they have been empty thus far.
-        // An 'evenly sized' maze is assumed, i.e. every row has the same number of columns.
-        for (int z = 0; z < maze[1].size(); ++z) {
-            maze[0].emplace_back(PipeType::NONE); // first row
-            maze.back().emplace_back(PipeType::NONE); // last row
-        }
-
-        auto &S = maze.at(SX, SY);
-        if (S.type() != PipeType::UNKNOWN) {
-            throw std::logic_error("Wrongly assigned S coords.");
-        }
 
         // Figure out what 'S' is supposed to be.
-        auto &left = maze.at(SX - 1, SY); //[startY][startX - 1];
-        auto &right = maze.at(SX + 1, SY);//[startY][startX + 1];
-        auto &up = maze.at(SX, SY - 1);   //[startY - 1][startX];
-        auto &down = maze.at(SX, SY + 1); //[startY + 1][startX];
-
-        PipeTypeEnumType possible_s_directions = none_bit;
-        if (left.hasRight()) possible_s_directions |= left_bit;
-        if (right.hasLeft()) possible_s_directions |= right_bit;
-        if (down.hasUp()) possible_s_directions |= down_bit;
-        if (up.hasDown()) possible_s_directions |= up_bit;
-
-        switch (possible_s_directions) {
-            default:
-                throw std::logic_error("Possible S directions should be exactly two bits. Got: " + std::to_string(possible_s_directions));
-            case static_cast<PipeTypeEnumType>(PipeType::LEFTRIGHT):
-            case static_cast<PipeTypeEnumType>(PipeType::UPDOWN):
-            case static_cast<PipeTypeEnumType>(PipeType::LEFTUP):
-            case static_cast<PipeTypeEnumType>(PipeType::UPRIGHT):
-            case static_cast<PipeTypeEnumType>(PipeType::RIGHTDOWN):
-            case static_cast<PipeTypeEnumType>(PipeType::DOWNLEFT):
-                S = PipeSegment(static_cast<PipeType>(possible_s_directions));
-                break;
+        uint8_t possible_s_directions = none_bit;
+        if (grid.at(SX - 1, SY) & right_bit) possible_s_directions |= left_bit;
+        if (grid.at(SX + 1, SY) & left_bit) possible_s_directions |= right_bit;
+        if (grid.at(SX, SY + 1) & up_bit) possible_s_directions |= down_bit;
+        if (grid.at(SX, SY - 1) & down_bit) possible_s_directions |= up_bit;
+
+        if (std::popcount(possible_s_directions) != 2) {
+            throw std::logic_error("Possible S directions should be exactly two bits. Got: " + std::to_string(possible_s_directions));
         }
+        grid.set(SX, SY, possible_s_directions);
 
         startX = SX;
         startY = SY;
     }
 
     void v1() const override {
-        int steps = 0;
-        int x = startX;
-        int y = startY;
-        auto cameFrom = Direction::NONE;
-        do {
-            auto& place = maze.at(x, y);
-            cameFrom = tryTravel(place, cameFrom);
-            switch (cameFrom) {
-                case Direction::UP:     y--; cameFrom = Direction::DOWN;    break;
-                case Direction::DOWN:   y++; cameFrom = Direction::UP;      break;
-                case Direction::LEFT:   x--; cameFrom = Direction::RIGHT;   break;
-                case Direction::RIGHT:  x++; cameFrom = Direction::LEFT;    break;
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "UnreachableCode"
-                default: throw std::logic_error("Impossible travel direction given by tryTravel().");
-#pragma clang diagnostic pop
-            }
-            steps++;
-        } while (! (x == startX && y == startY));
-
+        int steps = walkLoop([](int, int, uint8_t) {});
         reportSolution(steps / 2);
     }
 
+#if SCANLINE_PARITY
+    /**
+     * Going along a row from the left, a tile is inside the loop when the loop was crossed an odd number of times before it.
+     * Only the loop pipes that connect upwards count as a crossing: '|', 'L' and 'J'. 'L-7' is one crossing and 'L-J' is zero,
+     * which is what counting just the upward halves gives.
+     * The loop and its upward pipes are two bitplanes. Crossing parity is then a prefix XOR within a word, carried into the next.
+     */
+    void v2() const override {
+        const int height = grid.height();
+        Bitplane loop(grid.width(), height);
+        Bitplane north(grid.width(), height);
+        walkLoop([&](int x, int y, uint8_t pipe) {
+            loop.set(x, y);
+            if (pipe & up_bit) north.set(x, y);
+        });
+
+        auto enclosedInRow = [&](int64_t y) -> int64_t {
+            const uint64_t * loopRow = loop.row(static_cast<int>(y));
+            const uint64_t * northRow = north.row(static_cast<int>(y));
+            int64_t enclosed = 0;
+            uint64_t inside = 0; // all ones when an odd number of crossings came before this word.
+            for (int w = 0; w < loop.wordsPerRow(); ++w) {
+                uint64_t parity = northRow[w];
+                for (int shift = 1; shift < 64; shift *= 2) parity ^= parity << shift;
+                parity ^= inside;
+                enclosed += __builtin_popcountll(parity & ~loopRow[w]);
+                inside = 0 - (parity >> 63);
+            }
+            return enclosed;
+        };
+
+#if USE_TASK_POOL
+        int64_t enclosedTiles = parallelReduce(0, height, int64_t{0}, enclosedInRow, std::plus<>{}, ROWS_PER_TASK);
+#else
+        int64_t enclosedTiles = 0;
+        for (int y = 0; y < height; ++y) enclosedTiles += enclosedInRow(y);
+#endif
+
+        reportSolution(enclosedTiles);
+    }
+#else
     void v2() const override {
         Maze<PipeSegment> explodedMaze;
-        explodeMaze(explodedMaze);
+        explodeMaze(grid.toMaze(), explodedMaze);
 
         Maze<SearchablePipeSegment> BFSWorksheet; // fully blank maze, to be painted by the loop detection process.
 
@@ -342,18 +406,50 @@ public:
 
         reportSolution(enclosedTiles);
     }
+#endif
 
     void parseBenchReset() override {
         startX = 0;
         startY = 0;
-        maze.clear();
+        grid = PipeGrid();
     }
 
 private:
-    Maze<PipeSegment> maze;
+    static constexpr int64_t ROWS_PER_TASK = 1024;
+
+    PipeGrid grid;
     int startX = 0;
     int startY = 0;
 
+    // Follows the loop from S back to S, calling visit(x, y, pipe) on every tile of it. Returns the length of the loop.
+    // Only the flat index is carried along the way. The way out comes from Walk::EXIT, but the step is a switch on purpose:
+    // both the index and the next entry side follow from a predicted branch, so the next tile can be loaded before this one is.
+    // Computing them from the table value (or letting the compiler cmov them) makes every step wait for the previous load.
+    template<typename F>
+    int walkLoop(F&& visit) const {
+        const size_t width = grid.width();
+        const size_t start = startY * width + startX;
+
+        int steps = 0;
+        size_t i = start;
+        uint8_t pipe = grid.at(i);
+        int entry = 31 - __builtin_clz(pipe); // S is left through its other side.
+        do {
+            visit(static_cast<int>(i % width), static_cast<int>(i / width), pipe);
+            switch (Walk::EXIT[pipe][entry]) {
+                case 0: i -= 1; entry = 1; break;
+                case 1: i += 1; entry = 0; break;
+                case 2: i -= width; entry = 3; break;
+                case 3: i += width; entry = 2; break;
+                default:
+                    throw std::logic_error("Impossible pipe configuration, cannot travel. Pipe: " + std::to_string(pipe) + ", Entered from: " + std::to_string(entry));
+            }
+            pipe = grid.at(i);
+            steps++;
+        } while (i != start);
+        return steps;
+    }
+
     static Direction tryTravel(const PipeSegment &from, const Direction &enterDirection) {
         auto e = static_cast<DirectionEnumType>(enterDirection);
 
@@ -406,7 +502,7 @@ private:
     // becomes:
     //  'F-'   'J|'   '||'
     //  '|F'   '-J'   '||'
-    void explodeMaze(Maze<PipeSegment>& worksheet) const {
+    static void explodeMaze(const Maze<PipeSegment>& maze, Maze<PipeSegment>& worksheet) {
         worksheet.resize(maze.size() * 2);
         for (int i = 0; i < worksheet.size(); ++i) {
             auto& row = worksheet[i];
@@ -546,4 +642,6 @@ private:
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef SCANLINE_PARITY
+#undef USE_TASK_POOL
\ No newline at end of file
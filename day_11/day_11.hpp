@@ -1,12 +1,19 @@
 #pragma once
 
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <string_view>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
+#include "day_11_simd.hpp"
 
 #define DAY 11
 
+#define PREFIX_SUM_DISTANCES true // only count galaxies per row and column, and sum distances per axis. Any expansion, no pairs.
+#define BRUTE_FORCE_PAIRS false // also do every pair, SIMD on all threads. Prints pairs per second, and has to agree with the prefix sums.
+
 NAMESPACE_DEF(DAY) {
 
 struct Galaxy {
@@ -27,12 +34,156 @@ std::ostream& operator<<(std::ostream& os, const Galaxy& g) {
 
 constexpr int P2_GALAXY_EXPANSION_FACTOR = 1'000'000;
 
+/**
+ * The number of galaxies in every row and every column, before expansion.
+ * Manhattan distance is per axis, and on one axis the sum over all pairs only needs the galaxies sorted, which the rows already are:
+ * a galaxy at p adds (galaxies before it) * p - (sum of their positions).
+ * Expansion only changes the positions: an empty row or column is 'expansion' wide instead of 1. So any factor is O(rows + columns).
+ */
+class GalaxyCounts {
+public:
+    using int128 = __int128;
+
+    void addRow(std::string_view row) {
+        if (rows.empty()) {
+            columns.assign(row.size(), 0);
+        } else if (row.size() != columns.size()) {
+            throw std::logic_error("Every line should have the same amount of columns");
+        }
+
+        int64_t n = 0;
+        for (size_t x = 0; x < row.size(); ++x) {
+            if (row[x] == '#') {
+                columns[x]++;
+                n++;
+            }
+        }
+        rows.push_back(n);
+    }
+
+    [[nodiscard]] int128 distanceSum(int64_t expansion) const {
+        return axisSum(rows, expansion) + axisSum(columns, expansion);
+    }
+
+    // where every row (or column) ends up after expansion.
+    [[nodiscard]] std::vector<int64_t> rowPositions(int64_t expansion) const { return positions(rows, expansion); }
+    [[nodiscard]] std::vector<int64_t> columnPositions(int64_t expansion) const { return positions(columns, expansion); }
+
+    [[nodiscard]] size_t height() const { return rows.size(); }
+
+    void clear() {
+        rows.clear();
+        columns.clear();
+    }
+
+private:
+    std::vector<int64_t> rows;
+    std::vector<int64_t> columns;
+
+    static std::vector<int64_t> positions(const std::vector<int64_t>& counts, int64_t expansion) {
+        std::vector<int64_t> result;
+        int64_t position = 0;
+        for (int64_t c : counts) {
+            result.push_back(position);
+            position += c == 0 ? expansion : 1;
+        }
+        return result;
+    }
+
+    static int128 axisSum(const std::vector<int64_t>& counts, int64_t expansion) {
+        int128 position = 0;
+        int128 seen = 0;
+        int128 seenPositions = 0;
+        int128 sum = 0;
+        for (int64_t c : counts) {
+            if (c == 0) {
+                position += expansion;
+                continue;
+            }
+            sum += c * (seen * position - seenPositions);
+            seen += c;
+            seenPositions += c * position;
+            position += 1;
+        }
+        return sum;
+    }
+};
+
 CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
+#if PREFIX_SUM_DISTANCES
+    void parse(std::istream &input) override {
+        std::string line;
+        while (std::getline(input, line)) {
+            if (! line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+#if BRUTE_FORCE_PAIRS
+            for (size_t x = line.find('#'); x != std::string::npos; x = line.find('#', x + 1)) {
+                galaxies.emplace_back(static_cast<int>(x), static_cast<int>(counts.height()));
+            }
+#endif
+            counts.addRow(line);
+        }
+    }
+
+    void v1() const override {
+        reportSolution(solveProblem(2));
+    }
+
+    void v2() const override {
+        reportSolution(solveProblem(P2_GALAXY_EXPANSION_FACTOR));
+    }
+
+    void parseBenchReset() override {
+        counts.clear();
+        galaxies.clear();
+    }
+
+    [[nodiscard]] int64_t solveProblem(int64_t expansion) const {
+        int64_t sum = distanceSum(expansion);
+#if BRUTE_FORCE_PAIRS
+        crunch(expansion, sum);
+#endif
+        return sum;
+    }
+
+    [[nodiscard]] int64_t distanceSum(int64_t expansion) const {
+        auto sum = counts.distanceSum(expansion);
+        if (sum > std::numeric_limits<int64_t>::max()) {
+            throw std::logic_error("Galaxy distances do not fit 64 bits for expansion " + std::to_string(expansion));
+        }
+        return static_cast<int64_t>(sum);
+    }
+
+private:
+    GalaxyCounts counts;
+    std::vector<Galaxy> galaxies; // unexpanded. Only for the brute force.
+
+    // every pair. Throws if it does not come out the same as the prefix sums.
+    void crunch(int64_t expansion, int64_t expected) const {
+        const auto rows = counts.rowPositions(expansion);
+        const auto columns = counts.columnPositions(expansion);
+        Simd::Galaxies expanded;
+        for (const auto& g : galaxies) {
+            expanded.x.push_back(columns[g.x]);
+            expanded.y.push_back(rows[g.y]);
+        }
+
+        std::cout << "Crunching " << expanded.pairs() << " pairs on " << omp_get_max_threads() << " threads\n";
+        auto start = std::chrono::steady_clock::now();
+        Simd::int128 sum = Simd::pairDistanceSum(expanded);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "The crunch took " << sec << " seconds: " << (static_cast<double>(expanded.pairs()) / sec) << " pairs per second\n";
+
+        if (sum != expected) {
+            throw std::logic_error("Brute force and prefix sums disagree for expansion " + std::to_string(expansion));
+        }
+    }
+#else
     // Assumes a rectangular input; Every line should have the same amount of columns.
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         int columns = 0;
         while (input.get() != '\n') {
             columns++;
@@ -127,8 +278,11 @@ private:
 
     std::vector<Galaxy> galaxies;
     std::vector<Galaxy> veryExpandedGalaxies; // problem 2. since we do not want to mutate the vector after parsing once, we should parse in the 2 variants separately.
+#endif
 };
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef PREFIX_SUM_DISTANCES
+#undef BRUTE_FORCE_PAIRS
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 11, for the embedded input mode. Same answers as Day11, computed from a string_view.
+ * Pairwise distances per axis with prefix sums over galaxy counts, instead of a loop over all pairs.
+ */
+namespace Day11::Constexpr {
+
+// Sum of |a - b| over all pairs of galaxies on one axis. counts[i] is the number of galaxies in row (or column) i.
+// Empty rows (or columns) count as 'expansion' units wide.
+constexpr int64_t axisDistance(const std::vector<int64_t>& counts, int64_t expansion) {
+    int64_t coordinate = 0;
+    int64_t seen = 0; // galaxies before this row
+    int64_t coordinateSum = 0; // sum of their coordinates
+    int64_t total = 0;
+    for (auto c : counts) {
+        total += c * (seen * coordinate - coordinateSum);
+        seen += c;
+        coordinateSum += c * coordinate;
+        coordinate += (c == 0 ? expansion : 1);
+    }
+    return total;
+}
+
+constexpr int64_t solve(std::string_view input, int64_t expansion) {
+    std::vector<int64_t> rows;
+    std::vector<int64_t> cols;
+
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    while (lines.next(line)) {
+        if (line.empty()) continue;
+        if (cols.size() < line.size()) cols.resize(line.size(), 0);
+
+        int64_t inRow = 0;
+        for (size_t x = 0; x < line.size(); ++x) {
+            if (line[x] == '#') {
+                ++inRow;
+                ++cols[x];
+            }
+        }
+        rows.push_back(inRow);
+    }
+
+    return axisDistance(rows, expansion) + axisDistance(cols, expansion);
+}
+
+constexpr int64_t v1(std::string_view input) { return solve(input, 2); }
+constexpr int64_t v2(std::string_view input) { return solve(input, 1'000'000); }
+
+} // namespace
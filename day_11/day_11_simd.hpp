@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+#include <omp.h>
+
+#include "../util/Cpu.hpp"
+
+/**
+ * Day 11 the slow way, on purpose: every pair of galaxies, as a compute benchmark and to check the prefix sums against.
+ * Galaxies are two flat arrays of expanded coordinates. Row i is galaxy i against every galaxy after it,
+ * 4 at a time in AVX2: subtract, absolute value, add.
+ * Row i has n - 1 - i pairs, so the rows are cut into blocks of about the same number of pairs for the OpenMP threads.
+ */
+namespace Day11::Simd {
+
+using int128 = __int128;
+
+constexpr size_t BLOCKS_PER_THREAD = 8;
+
+struct Galaxies {
+    std::vector<int64_t> x;
+    std::vector<int64_t> y;
+
+    [[nodiscard]] size_t size() const { return x.size(); }
+    [[nodiscard]] int64_t pairs() const { return static_cast<int64_t>(size()) * (static_cast<int64_t>(size()) - 1) / 2; }
+};
+
+// Sum over j > i of |x_i - x_j| + |y_i - y_j|. One row stays below n * the largest distance, which fits 64 bits.
+inline int64_t rowSumScalar(const Galaxies& g, size_t i) {
+    int64_t sum = 0;
+    for (size_t j = i + 1; j < g.size(); ++j) {
+        sum += std::abs(g.x[i] - g.x[j]) + std::abs(g.y[i] - g.y[j]);
+    }
+    return sum;
+}
+
+#if AOC_X86 == true
+// |d| without AVX-512: flip the negative ones and add one, which is (d ^ sign) - sign.
+__attribute__((target("avx2"))) inline __m256i abs64(__m256i d) {
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), d);
+    return _mm256_sub_epi64(_mm256_xor_si256(d, sign), sign);
+}
+
+__attribute__((target("avx2"))) inline int64_t rowSumAvx2(const Galaxies& g, size_t i) {
+    const __m256i xi = _mm256_set1_epi64x(g.x[i]);
+    const __m256i yi = _mm256_set1_epi64x(g.y[i]);
+    __m256i acc = _mm256_setzero_si256();
+
+    size_t j = i + 1;
+    for (; j + 4 <= g.size(); j += 4) {
+        __m256i xj = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&g.x[j]));
+        __m256i yj = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&g.y[j]));
+        acc = _mm256_add_epi64(acc, abs64(_mm256_sub_epi64(xi, xj)));
+        acc = _mm256_add_epi64(acc, abs64(_mm256_sub_epi64(yi, yj)));
+    }
+
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; j < g.size(); ++j) {
+        sum += std::abs(g.x[i] - g.x[j]) + std::abs(g.y[i] - g.y[j]);
+    }
+    return sum;
+}
+#endif
+
+// Cuts rows [0, n) into 'blocks' ranges, given by their first rows, with about the same number of pairs each.
+inline std::vector<size_t> balancedBlocks(size_t n, size_t blocks) {
+    const int128 total = static_cast<int128>(n) * (n > 0 ? n - 1 : 0) / 2;
+    std::vector<size_t> begins { 0 };
+    int128 done = 0;
+    for (size_t i = 0; i < n; ++i) {
+        done += n - 1 - i;
+        if (begins.size() < blocks && done * blocks >= total * begins.size()) begins.push_back(i + 1);
+    }
+    begins.push_back(n);
+    return begins;
+}
+
+inline int128 pairDistanceSum(const Galaxies& g) {
+    auto rowSum = rowSumScalar;
+#if AOC_X86 == true
+    if (Cpu::haveAvx2()) rowSum = rowSumAvx2;
+#endif
+
+    const auto begins = balancedBlocks(g.size(), static_cast<size_t>(omp_get_max_threads()) * BLOCKS_PER_THREAD);
+    const size_t nBlocks = begins.size() - 1;
+    std::vector<int128> blockSums(nBlocks, 0); // OpenMP can not reduce an int128.
+
+#pragma omp parallel for schedule(dynamic, 1) default(none) shared(g, begins, blockSums, rowSum, nBlocks)
+    for (size_t b = 0; b < nBlocks; ++b) {
+        int128 sum = 0;
+        for (size_t i = begins[b]; i < begins[b + 1]; ++i) sum += rowSum(g, i);
+        blockSums[b] = sum;
+    }
+
+    return std::accumulate(blockSums.begin(), blockSums.end(), int128{0});
+}
+
+} // namespace
@@ -1,12 +1,24 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 12
 
+#define USE_TASK_POOL true // records are independent, count them on the work-stealing pool.
+#define TABULATED_DP true // count bottom-up in two flat rows per record, instead of the memoised recursion.
+#define BENCH_UNFOLDING false // v2 also times 5x and 50x unfolded records, counted exactly in 512 bits.
+
 NAMESPACE_DEF(DAY) {
 
 struct SpringRecord {
@@ -110,6 +122,110 @@ struct SpringRecord {
     }
 };
 
+/**
+ * The count without recursion. Put a '.' after the record, then every group of k is k springs and the '.' after it.
+ * ways[p] (for g groups) = the ways to have exactly the first g groups in the first p characters, with every '#' in there covered.
+ * From there, character p is either a '.' (when it is not a '#'), or group g starts there and takes k + 1 characters
+ * (when there is no '.' among its k, and no '#' right after). The '.' test is a difference of prefix counts.
+ * One row per number of groups, and only two are ever needed: O(length * groups), in buffers that are reused between records.
+ * The counts are uint64_t for the puzzle. Records unfolded 50 times have counts of hundreds of bits, those use Big.
+ */
+namespace Tabulated {
+
+// 512 bit unsigned integer, only as much of one as the counting needs. Throws instead of overflowing.
+struct Big {
+    static constexpr size_t LIMBS = 8;
+    std::array<uint64_t, LIMBS> limbs {}; // least significant first.
+
+    Big() = default;
+    Big(uint64_t v) : limbs { v } {} // NOLINT(google-explicit-constructor) -- so that the template can treat it like a number.
+
+    Big& operator+=(const Big& o) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            unsigned __int128 sum = static_cast<unsigned __int128>(limbs[i]) + o.limbs[i] + carry;
+            limbs[i] = static_cast<uint64_t>(sum);
+            carry = static_cast<uint64_t>(sum >> 64);
+        }
+        if (carry != 0) throw std::logic_error("Arrangement count overflows 512 bits");
+        return *this;
+    }
+
+    friend Big operator+(Big a, const Big& b) { return a += b; }
+    bool operator==(const Big& o) const = default;
+
+    [[nodiscard]] std::string toString() const {
+        constexpr uint64_t CHUNK = 10'000'000'000'000'000'000ull; // 10^19, the most decimal digits that fit a limb.
+        std::vector<uint64_t> chunks; // least significant first.
+        auto left = limbs;
+        while (left != decltype(left){}) {
+            unsigned __int128 remainder = 0;
+            for (size_t i = LIMBS; i > 0; --i) {
+                unsigned __int128 part = remainder << 64 | left[i - 1];
+                left[i - 1] = static_cast<uint64_t>(part / CHUNK);
+                remainder = part % CHUNK;
+            }
+            chunks.push_back(static_cast<uint64_t>(remainder));
+        }
+        if (chunks.empty()) return "0";
+
+        std::ostringstream os;
+        os << chunks.back();
+        for (size_t i = chunks.size() - 1; i > 0; --i) os << std::setw(19) << std::setfill('0') << chunks[i - 1];
+        return os.str();
+    }
+};
+
+template<typename T>
+T count(std::string_view data, const std::vector<int>& groups) {
+    thread_local std::vector<int32_t> dots; // dots[p] = '.' in the first p characters.
+    thread_local std::vector<T> ways;
+    thread_local std::vector<T> nextWays;
+
+    const size_t n = data.size() + 1;
+    auto at = [&data](size_t p) { return p < data.size() ? data[p] : '.'; };
+
+    dots.assign(n + 1, 0);
+    for (size_t p = 0; p < n; ++p) dots[p + 1] = dots[p] + (at(p) == '.');
+
+    ways.assign(n + 1, T{});
+    ways[0] = 1;
+    for (size_t g = 0; ; ++g) {
+        const bool last = g == groups.size();
+        const size_t k = last ? 0 : groups[g];
+        if (! last) nextWays.assign(n + 1, T{});
+
+        for (size_t p = 0; p < n; ++p) {
+            const T w = ways[p];
+            if (w == T{}) continue;
+            if (at(p) != '#') ways[p + 1] += w;
+            if (! last && p + k < n && dots[p + k] == dots[p] && at(p + k) != '#') nextWays[p + k + 1] += w;
+        }
+
+        if (last) return ways[n];
+        std::swap(ways, nextWays);
+    }
+}
+
+// the record, 'times' times, joined by '?'. The groups just repeat.
+template<typename T>
+T count(const SpringRecord& record, int times) {
+    if (times == 1) return count<T>(record.data, record.numbers);
+
+    thread_local std::string data;
+    thread_local std::vector<int> groups;
+    data.clear();
+    groups.clear();
+    for (int t = 0; t < times; ++t) {
+        if (t != 0) data.push_back('?');
+        data.append(record.data);
+        groups.insert(groups.end(), record.numbers.begin(), record.numbers.end());
+    }
+    return count<T>(data, groups);
+}
+
+}
+
 struct UnfoldedSpringRecord : public SpringRecord {
     explicit UnfoldedSpringRecord(const std::string& toUnfold) : SpringRecord(unfold(toUnfold)) {}
 
@@ -140,7 +256,57 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+#if TABULATED_DP
+    void parse(std::istream &input) override {
+        std::string line;
+        while (std::getline(input, line)) {
+            if (! line.empty()) records.emplace_back(line);
+        }
+    }
+
+    void v1() const override {
+        reportSolution(static_cast<int64_t>(sumArrangements<uint64_t>(1)));
+    }
+
+    void v2() const override {
+#if BENCH_UNFOLDING
+        benchUnfolding(5);
+        benchUnfolding(50);
+#endif
+        reportSolution(static_cast<int64_t>(sumArrangements<uint64_t>(5)));
+    }
+
+    void parseBenchReset() override {
+        records.clear();
+    }
+
+private:
+    std::vector<SpringRecord> records;
+
+    // Record sizes vary wildly (unfolded ones especially), so use small chunks and let the pool steal them around.
+    template<typename T>
+    [[nodiscard]] T sumArrangements(int times) const {
+        auto countOne = [this, times](int64_t i) { return Tabulated::count<T>(records[i], times); };
+#if USE_TASK_POOL
+        return parallelReduce(0, static_cast<int64_t>(records.size()), T{}, countOne, std::plus<>(), 4);
+#else
+        T sum {};
+        for (size_t i = 0; i < records.size(); ++i) sum += countOne(static_cast<int64_t>(i));
+        return sum;
+#endif
+    }
+
+    void benchUnfolding(int times) const {
+        constexpr int ROUNDS = 10;
+        auto start = std::chrono::steady_clock::now();
+        Tabulated::Big sum;
+        for (int r = 0; r < ROUNDS; ++r) sum = sumArrangements<Tabulated::Big>(times);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Unfolded " << times << "x: " << (static_cast<double>(records.size()) * ROUNDS / sec) << " records per second."
+                  << " Sum: " << sum.toString() << "\n";
+    }
+#else
+    void parse(std::istream &input) override {
         std::string line;
         while (std::getline(input, line)) {
             records.emplace_back(line);
@@ -149,16 +315,24 @@ public:
     }
 
     void v1() const override {
+#if USE_TASK_POOL
+        int sum = static_cast<int>(parallelCount(records));
+#else
         int sum = std::accumulate(records.begin(), records.end(), 0, [](int s, auto& item){
             return s + item.countPossibleRecords();
         });
+#endif
         reportSolution(sum);
     }
 
     void v2() const override {
+#if USE_TASK_POOL
+        int64_t sum = parallelCount(unfoldedRecords);
+#else
         int64_t sum = std::accumulate(unfoldedRecords.begin(), unfoldedRecords.end(), 0ll, [](int64_t s, auto& item){
             return s + item.countPossibleRecords();
         });
+#endif
         reportSolution(sum);
     }
 
@@ -170,8 +344,23 @@ public:
 private:
     std::vector<SpringRecord> records;
     std::vector<UnfoldedSpringRecord> unfoldedRecords;
+
+    // Record sizes vary wildly (unfolded ones especially), so use small chunks and let the pool steal them around.
+    template<typename R>
+    static int64_t parallelCount(const std::vector<R>& recs) {
+        return parallelReduce(
+            0, static_cast<int64_t>(recs.size()), int64_t{0},
+            [&recs](int64_t i) { return recs[i].countPossibleRecords(); },
+            std::plus<>(),
+            4
+        );
+    }
+#endif
 };
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
+#undef TABULATED_DP
+#undef BENCH_UNFOLDING
\ No newline at end of file
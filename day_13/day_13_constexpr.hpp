@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+#include "../util/ConstexprInput.hpp"
+
+/**
+ * Compile-time version of day 13, for the embedded input mode. Same answers as Day13, computed from a string_view.
+ */
+namespace Day13::Constexpr {
+
+constexpr int MAX_DIMENSION = 64; // same bound as the runtime MirrorableBitfield.
+
+struct Pattern {
+    std::array<std::string_view, MAX_DIMENSION> rows{};
+    int height = 0;
+    int width = 0;
+};
+
+// Mirror between column 'split - 1' and 'split', with exactly 'smudges' cells differing?
+constexpr bool verticalMirror(const Pattern& p, int split, int smudges) {
+    int diff = 0;
+    for (int y = 0; y < p.height; ++y) {
+        for (int l = split - 1, r = split; l >= 0 && r < p.width; --l, ++r) {
+            diff += p.rows[y][l] != p.rows[y][r];
+        }
+    }
+    return diff == smudges;
+}
+
+// Mirror between row 'split - 1' and 'split', with exactly 'smudges' cells differing?
+constexpr bool horizontalMirror(const Pattern& p, int split, int smudges) {
+    int diff = 0;
+    for (int u = split - 1, d = split; u >= 0 && d < p.height; --u, ++d) {
+        for (int x = 0; x < p.width; ++x) {
+            diff += p.rows[u][x] != p.rows[d][x];
+        }
+    }
+    return diff == smudges;
+}
+
+constexpr int64_t score(const Pattern& p, int smudges) {
+    for (int c = 1; c < p.width; ++c) {
+        if (verticalMirror(p, c, smudges)) return c;
+    }
+    for (int r = 1; r < p.height; ++r) {
+        if (horizontalMirror(p, r, smudges)) return 100 * r;
+    }
+    throw std::logic_error("pattern without mirror");
+}
+
+constexpr int64_t solve(std::string_view input, int smudges) {
+    ConstexprInput::Lines lines{input};
+    std::string_view line;
+    Pattern p;
+    int64_t sum = 0;
+    while (lines.next(line)) {
+        if (line.empty()) {
+            if (p.height > 0) sum += score(p, smudges);
+            p = Pattern{};
+            continue;
+        }
+        if (p.height == MAX_DIMENSION) throw std::logic_error("pattern too big");
+        p.rows[p.height++] = line;
+        p.width = static_cast<int>(line.size());
+    }
+    if (p.height > 0) sum += score(p, smudges); // no blank line after the last one.
+    return sum;
+}
+
+constexpr int64_t v1(std::string_view input) { return solve(input, 0); }
+constexpr int64_t v2(std::string_view input) { return solve(input, 1); }
+
+} // namespace
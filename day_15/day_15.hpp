@@ -147,7 +147,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::string line;
         std::getline(input, line);
         std::istringstream in(line);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string_view>
+
+/**
+ * Compile-time version of day 15 part 1, for the embedded input mode. Same answer as Day15::v1, computed from a string_view.
+ * (part 2 keeps running at runtime, its boxes of lenses are not worth the compile time.)
+ */
+namespace Day15::Constexpr {
+
+constexpr int64_t v1(std::string_view input) {
+    int64_t sum = 0;
+    int hash = 0;
+    for (char c : input) {
+        if (c == '\n' || c == '\r') continue; // newlines are ignored by the puzzle.
+        if (c == ',') {
+            sum += hash;
+            hash = 0;
+        } else {
+            hash = ((hash + static_cast<unsigned char>(c)) * 17) % 256;
+        }
+    }
+    return sum + hash;
+}
+
+} // namespace
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <omp.h>
+#include <set>
 
 #include "../util/Day.hpp"
 #include "../util/macros.hpp"
@@ -83,7 +84,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         int y = 0;
         int x = 0;
         int c = 0;
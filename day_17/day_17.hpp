@@ -161,7 +161,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::vector<std::vector<int>> grid;
         grid.emplace_back(); // assumes the grid is not empty :)
         int c;
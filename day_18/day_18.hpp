@@ -86,7 +86,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::string line;
         while (std::getline(input, line)) {
             instructions.emplace_back(line);
@@ -3,10 +3,13 @@
 #include <iostream>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 19
 
+#define USE_TASK_POOL true // fork the range recursion of problem 2 onto the work-stealing pool.
+
 NAMESPACE_DEF(DAY) {
 
 struct Object {
@@ -162,7 +165,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::string line;
         while (std::getline(input, line)) { // functors
             if (line.empty()) break;
@@ -191,7 +194,11 @@ public:
     }
 
     void v2() const override {
+#if USE_TASK_POOL
+        reportSolution(parallelCombinatorialCountWithRange(Range(), ENTRY_LABEL, 0));
+#else
         reportSolution(recursiveCombinatorialCountWithRange(Range(), ENTRY_LABEL));
+#endif
     }
 
     void parseBenchReset() override {
@@ -292,6 +299,56 @@ private:
         return combinationCount;
     }
 
+    // Below this depth, split-off ranges become tasks. Deeper down the subtrees are too small to be worth a task.
+    static constexpr int FORK_DEPTH = 6;
+
+    // Same walk as above, but every range that is split off to another label is forked, and the remainder is walked by this thread.
+    uint64_t parallelCombinatorialCountWithRange(const Range& r, const std::string& lbl, int depth) const {
+        if (depth >= FORK_DEPTH || lbl == ACCEPT_LABEL || lbl == REJECT_LABEL) {
+            return recursiveCombinatorialCountWithRange(r, lbl);
+        }
+
+        auto iter = rules.find(lbl);
+        if (iter == rules.end()) throw std::logic_error("lbl " + lbl + " Does not exist");
+
+        TaskGroup group;
+        std::vector<uint64_t> forked(iter->second.size(), 0); // one slot per rule, a rule forks at most once.
+        auto fork = [&, depth](const Range& part, const std::string& to, int ruleIndex) {
+            group.run([&, part, to, ruleIndex, depth](){
+                forked[ruleIndex] = parallelCombinatorialCountWithRange(part, to, depth + 1);
+            });
+        };
+
+        auto workingWith = r;
+        int ruleIndex = 0;
+        uint64_t combinationCount = 0;
+        while (! workingWith.empty()) { // same as the serial version: the last rule always covers the entire range.
+            auto& rule = iter->second[ruleIndex];
+            std::array<Range, 2> split;
+            int newRanges = workingWith.split(rule, split);
+            if (newRanges == 0) {
+                ruleIndex++;
+            } else if (newRanges == 1) {
+                combinationCount += parallelCombinatorialCountWithRange(workingWith, rule.remap, depth + 1);
+                break;
+            } else if (newRanges == 2) {
+                if (rule.comparator == '>') { // [0] does not satisfy the rule. [1] does.
+                    fork(split[1], rule.remap, ruleIndex);
+                    workingWith = split[0];
+                } else { // '<'. [0] satisfies the rule, [1] does not.
+                    fork(split[0], rule.remap, ruleIndex);
+                    workingWith = split[1];
+                }
+                ruleIndex++;
+            } else {
+                throw std::logic_error("Unknown number of split ranges");
+            }
+        }
+
+        group.wait();
+        return std::accumulate(forked.begin(), forked.end(), combinationCount);
+    }
+
     void addFunctor(const std::string& from) {
         std::istringstream s(from);
         std::ostringstream buf;
@@ -419,4 +476,5 @@ private:
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
\ No newline at end of file
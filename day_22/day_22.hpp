@@ -3,10 +3,13 @@
 #include <iostream>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 22
 
+#define USE_TASK_POOL true // chain reactions per brick are independent, spread them over the work-stealing pool.
+
 NAMESPACE_DEF(DAY) {
 
 struct Point;
@@ -53,7 +56,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::string line;
         int i = 0;
         while(std::getline(input, line)) {
@@ -166,8 +169,7 @@ public:
         makeLookupTable(inverseConnectionLookup, inverseConnections);
 
         // O(N^2 (K^2 logN)) where K is single digits for the puzzle input -> O(N^2 logN)
-        int64_t fallSum = 0;
-        for (auto& [cube, connections] : cons) { // O(N) w.r.t. input.
+        auto chainReaction = [&](const Cube * cube) -> int64_t {
             std::set<const Cube *> unstable;
             unstable.emplace(cube);
 
@@ -201,9 +203,26 @@ public:
                 }
             }
 
-            int unstables = static_cast<int>(unstable.size() - 1);
-            fallSum += unstables;
+            return static_cast<int>(unstable.size() - 1);
+        };
+
+        int64_t fallSum = 0;
+#if USE_TASK_POOL
+        // chain reactions of bricks low in the tower are huge, those high up are tiny. Small chunks, the pool balances it.
+        std::vector<const Cube *> order;
+        order.reserve(cons.size());
+        for (auto& [cube, _] : cons) order.push_back(cube);
+        fallSum = parallelReduce(
+            0, static_cast<int64_t>(order.size()), int64_t{0},
+            [&](int64_t i) { return chainReaction(order[i]); },
+            std::plus<>(),
+            16
+        );
+#else
+        for (auto& [cube, _] : cons) { // O(N) w.r.t. input.
+            fallSum += chainReaction(cube);
         }
+#endif
 
         reportSolution(fallSum);
     }
@@ -271,4 +290,5 @@ private:
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include <iostream>
 
 #include "../util/Day.hpp"
+#include "../util/TaskPool.hpp"
 #include "../util/macros.hpp"
 
 #define DAY 23
 
+#define USE_TASK_POOL true // fork the top of the problem 2 DFS onto the work-stealing pool.
+
 NAMESPACE_DEF(DAY) {
 
 struct Block {
@@ -49,7 +52,7 @@ CLASS_DEF(DAY) {
 public:
     DEFAULT_CTOR_DEF(DAY)
 
-    void parse(std::ifstream &input) override {
+    void parse(std::istream &input) override {
         std::string s;
         while (std::getline(input, s)) {
             grid.emplace_back(std::move(s));
@@ -86,7 +89,11 @@ public:
         // Extend connections to go backwards
         makeBidirectional(*iterToStart);
         std::vector<const Block *> visited;
+#if USE_TASK_POOL
+        auto [endReached, solution] = parallelLongestPathWithCircularDependencies(**iterToStart, *finalBlock, visited, 0);
+#else
         auto [endReached, solution] = calcLongestPathWithCircularDependencies(**iterToStart, *finalBlock, visited);
+#endif
         if (! endReached) {
             throw std::logic_error("End could not be reached from start??");
         }
@@ -130,6 +137,49 @@ private:
         }
     }
 
+    // Branching is at most 3 per block, so this gives up to 3^FORK_DEPTH tasks. Plenty to steal, few enough to not matter.
+    static constexpr int FORK_DEPTH = 8;
+
+    // Same search as above, but the first FORK_DEPTH levels fork every choice. Each task gets its own copy of the visited path.
+    static std::pair<bool, int> parallelLongestPathWithCircularDependencies(const Block& here, const Block& end, std::vector<const Block*>& visited, int depth) {
+        if (depth >= FORK_DEPTH) {
+            return calcLongestPathWithCircularDependencies(here, end, visited);
+        }
+        if (&here == &end) {
+            return {true, here.cost};
+        }
+
+        visited.push_back(&here);
+
+        std::vector<std::pair<bool, int>> choices(here.successors.size(), {false, 0});
+        {
+            TaskGroup group;
+            int i = 0;
+            for (auto& s : here.successors) {
+                if (std::find(visited.begin(), visited.end(), s.get()) == visited.end()) {
+                    group.run([&end, &result = choices[i], next = s.get(), path = visited, depth]() mutable {
+                        result = parallelLongestPathWithCircularDependencies(*next, end, path, depth + 1);
+                    });
+                }
+                ++i;
+            }
+            group.wait();
+        }
+
+        visited.pop_back();
+
+        bool endIsInThisPath = false;
+        int maxOfChoice = 0;
+        for (auto [endReaching, maxWithThisChoice] : choices) {
+            if (endReaching) {
+                endIsInThisPath = true;
+                maxOfChoice = std::max(maxOfChoice, maxWithThisChoice);
+            }
+        }
+
+        return {endIsInThisPath, here.cost + maxOfChoice};
+    }
+
     // NP-hard :) that's why we collapsed to blocks.
     static int calcLongestPath(const Block& first) {
         int max = 0;
@@ -303,4 +353,5 @@ private:
 
 } // namespace
 
-#undef DAY
\ No newline at end of file
+#undef DAY
+#undef USE_TASK_POOL
\ No newline at end of file
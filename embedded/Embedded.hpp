@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "../util/Day.hpp"
+
+/**
+ * Opt-in build mode (cmake -DAOC_EMBED_INPUTS=ON) where the cheap days are solved by the compiler.
+ *
+ * At configure time every dayN.txt is turned into a generated header with a constexpr char array.
+ * Each embedded/day_N.cpp evaluates the constexpr solvers of day_N_constexpr.hpp on it into a constinit constant.
+ * One translation unit per day, so the build can report what each day costs at compile time. (see time_compile.cmake)
+ */
+namespace Embedded {
+
+// nullopt parts are not solved at compile time.
+struct Answers {
+    std::optional<int64_t> v1;
+    std::optional<int64_t> v2;
+};
+
+extern const Answers DAY1;
+extern const Answers DAY2;
+extern const Answers DAY4;
+extern const Answers DAY6;
+extern const Answers DAY9;
+extern const Answers DAY11;
+extern const Answers DAY13;
+extern const Answers DAY15;
+
+/**
+ * The regular solver for a day, but parts with a compile-time answer just report it.
+ * If both parts are known there is nothing to parse either.
+ */
+template<typename Runtime>
+class EmbeddedDay : public Runtime {
+public:
+    explicit EmbeddedDay(const Answers& answers) : answers(answers) {}
+
+    void parse(std::istream& input) override {
+        if (! fullyEmbedded()) Runtime::parse(input);
+    }
+
+    void parseBenchReset() override {
+        if (! fullyEmbedded()) Runtime::parseBenchReset();
+    }
+
+    void v1() const override {
+        if (answers.v1) this->reportSolution(*answers.v1);
+        else Runtime::v1();
+    }
+
+    void v2() const override {
+        if (answers.v2) this->reportSolution(*answers.v2);
+        else Runtime::v2();
+    }
+
+private:
+    const Answers& answers;
+
+    [[nodiscard]] bool fullyEmbedded() const { return answers.v1 && answers.v2; }
+};
+
+} // namespace
@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day1_input.hpp"
+#include "../day_01/day_1_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY1 {
+    Day1::Constexpr::v1(DAY1_INPUT),
+    Day1::Constexpr::v2(DAY1_INPUT),
+};
+
+} // namespace
@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day11_input.hpp"
+#include "../day_11/day_11_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY11 {
+    Day11::Constexpr::v1(DAY11_INPUT),
+    Day11::Constexpr::v2(DAY11_INPUT),
+};
+
+} // namespace
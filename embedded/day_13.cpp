@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day13_input.hpp"
+#include "../day_13/day_13_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY13 {
+    Day13::Constexpr::v1(DAY13_INPUT),
+    Day13::Constexpr::v2(DAY13_INPUT),
+};
+
+} // namespace
@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day15_input.hpp"
+#include "../day_15/day_15_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY15 {
+    Day15::Constexpr::v1(DAY15_INPUT),
+    std::nullopt, // part 2 runs at runtime.
+};
+
+} // namespace
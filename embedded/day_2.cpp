@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day2_input.hpp"
+#include "../day_02/day_2_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY2 {
+    Day2::Constexpr::v1(DAY2_INPUT),
+    Day2::Constexpr::v2(DAY2_INPUT),
+};
+
+} // namespace
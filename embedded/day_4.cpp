@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day4_input.hpp"
+#include "../day_04/day_4_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY4 {
+    Day4::Constexpr::v1(DAY4_INPUT),
+    Day4::Constexpr::v2(DAY4_INPUT),
+};
+
+} // namespace
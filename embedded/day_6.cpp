@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day6_input.hpp"
+#include "../day_06/day_6_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY6 {
+    Day6::Constexpr::v1(DAY6_INPUT),
+    Day6::Constexpr::v2(DAY6_INPUT),
+};
+
+} // namespace
@@ -0,0 +1,12 @@
+#include "Embedded.hpp"
+#include "day9_input.hpp"
+#include "../day_09/day_9_constexpr.hpp"
+
+namespace Embedded {
+
+constinit const Answers DAY9 {
+    Day9::Constexpr::v1(DAY9_INPUT),
+    Day9::Constexpr::v2(DAY9_INPUT),
+};
+
+} // namespace
@@ -0,0 +1,30 @@
+# Compiler launcher for the embedded solutions: runs the compile command after '--' and reports how long it took.
+# All the constexpr solving happens in the compiler, so this is the cost of a day in the embedded mode.
+#   cmake -P time_compile.cmake -- <compiler> <args...>
+
+set(command "")
+set(source "")
+set(next_is_source FALSE)
+math(EXPR last "${CMAKE_ARGC} - 1")
+foreach (i RANGE 4 ${last})
+    set(arg "${CMAKE_ARGV${i}}")
+    list(APPEND command "${arg}")
+    if (next_is_source)
+        set(source "${arg}")
+        set(next_is_source FALSE)
+    elseif (arg STREQUAL "-c")
+        set(next_is_source TRUE)
+    endif()
+endforeach()
+
+string(TIMESTAMP start "%s%f") # microseconds since epoch.
+execute_process(COMMAND ${command} RESULT_VARIABLE result)
+string(TIMESTAMP end "%s%f")
+
+math(EXPR elapsed_ms "(${end} - ${start}) / 1000")
+get_filename_component(name "${source}" NAME)
+message("[compile time] ${name}: ${elapsed_ms} ms")
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "compilation of ${name} failed")
+endif()
@@ -1,6 +1,13 @@
+#include <charconv>
 #include <iostream>
 #include <memory>
 #include <map>
+#include <string_view>
+#include <omp.h>
+
+#include "util/TaskPool.hpp"
+#include "util/BatchRunner.hpp"
+#include "util/Distributed.hpp"
 
 #include "_template/placeholders.hpp"
 #include "day_01/day_1.hpp"
@@ -29,6 +36,14 @@
 #include "day_24/day_24.hpp"
 #include "day_25/day_25.hpp"
 
+#ifdef AOC_EMBED_INPUTS
+#include "embedded/Embedded.hpp"
+// days solved at compile time get a solver that reports the precomputed answers.
+#define EMBEDDED_OR_RUNTIME(N) [](){ return std::make_unique<Embedded::EmbeddedDay<Day##N::Day##N>>(Embedded::DAY##N); }
+#else
+#define EMBEDDED_OR_RUNTIME(N) [](){ return std::make_unique<Day##N::Day##N>(); }
+#endif
+
 enum class ExitCodes {
     OK = 0,
     NO_INPUT = -1,
@@ -36,21 +51,21 @@ enum class ExitCodes {
 };
 
 std::map<int, std::function<std::unique_ptr<Day>()>> day_constructor_functions = {
-        { 1, [](){ return std::make_unique<Day1::Day1>(); } },
-        { 2, [](){ return std::make_unique<Day2::Day2>(); } },
+        { 1, EMBEDDED_OR_RUNTIME(1) },
+        { 2, EMBEDDED_OR_RUNTIME(2) },
         { 3, [](){ return std::make_unique<Day3::Day3>(); } },
-        { 4, [](){ return std::make_unique<Day4::Day4>(); } },
+        { 4, EMBEDDED_OR_RUNTIME(4) },
         { 5, [](){ return std::make_unique<Day5::Day5>(); } },
-        { 6, [](){ return std::make_unique<Day6::Day6>(); } },
+        { 6, EMBEDDED_OR_RUNTIME(6) },
         { 7, [](){ return std::make_unique<Day7::Day7>(); } },
         { 8, [](){ return std::make_unique<Day8::Day8>(); } },
-        { 9, [](){ return std::make_unique<Day9::Day9>(); } },
+        { 9, EMBEDDED_OR_RUNTIME(9) },
         { 10,[](){ return std::make_unique<Day10::Day10>(); } },
-        { 11,[](){ return std::make_unique<Day11::Day11>(); } },
+        { 11,EMBEDDED_OR_RUNTIME(11) },
         { 12,[](){ return std::make_unique<Day12::Day12>(); } },
-        { 13,[](){ return std::make_unique<Day13::Day13>(); } },
+        { 13,EMBEDDED_OR_RUNTIME(13) },
         { 14,[](){ return std::make_unique<Day14::Day14>(); } },
-        { 15,[](){ return std::make_unique<Day15::Day15>(); } },
+        { 15,EMBEDDED_OR_RUNTIME(15) },
         { 16,[](){ return std::make_unique<Day16::Day16>(); } },
         { 17,[](){ return std::make_unique<Day17::Day17>(); } },
         { 18,[](){ return std::make_unique<Day18::Day18>(); } },
@@ -63,8 +78,19 @@ std::map<int, std::function<std::unique_ptr<Day>()>> day_constructor_functions =
         { 25,[](){ return std::make_unique<Day25::Day25>(); } },
 };
 
-int benchEverything() {
-    std::vector<std::array<BenchmarkStats, 3>> stats(day_constructor_functions.size());
+// Solvers that do not open day_NN/dayN.txt, for batch mode and workers. Never the embedded ones: their answers are for that one input.
+#define WITHOUT_INPUT(N) [](){ return std::make_unique<Day##N::Day##N>(Day::WithoutInput{}); }
+
+std::map<int, std::function<std::unique_ptr<Day>()>> day_without_input_functions = {
+        { 1, WITHOUT_INPUT(1) },  { 2, WITHOUT_INPUT(2) },  { 3, WITHOUT_INPUT(3) },  { 4, WITHOUT_INPUT(4) },  { 5, WITHOUT_INPUT(5) },
+        { 6, WITHOUT_INPUT(6) },  { 7, WITHOUT_INPUT(7) },  { 8, WITHOUT_INPUT(8) },  { 9, WITHOUT_INPUT(9) },  { 10, WITHOUT_INPUT(10) },
+        { 11, WITHOUT_INPUT(11) }, { 12, WITHOUT_INPUT(12) }, { 13, WITHOUT_INPUT(13) }, { 14, WITHOUT_INPUT(14) }, { 15, WITHOUT_INPUT(15) },
+        { 16, WITHOUT_INPUT(16) }, { 17, WITHOUT_INPUT(17) }, { 18, WITHOUT_INPUT(18) }, { 19, WITHOUT_INPUT(19) }, { 20, WITHOUT_INPUT(20) },
+        { 21, WITHOUT_INPUT(21) }, { 22, WITHOUT_INPUT(22) }, { 23, WITHOUT_INPUT(23) }, { 24, WITHOUT_INPUT(24) }, { 25, WITHOUT_INPUT(25) },
+};
+
+// bench_all sample count per day.
+int getSampleSize(int day) {
     int defaultSampleSize = 10000;
     static const std::map<int, int> sampleSizeOverrides {
             {3, 1000},
@@ -82,17 +108,15 @@ int benchEverything() {
             {23, 10},
             {25, 500}
     };
-    auto getSampleSize = [defaultSampleSize](int day){
-        auto iter = std::find_if(
-                sampleSizeOverrides.begin(),
-                sampleSizeOverrides.end(),
-                [day](auto& pair){ return pair.first == day; }
-        );
-
-        if (iter != sampleSizeOverrides.end()) {
-            return iter->second;
-        } else return defaultSampleSize;
-    };
+
+    auto iter = sampleSizeOverrides.find(day);
+    if (iter != sampleSizeOverrides.end()) {
+        return iter->second;
+    } else return defaultSampleSize;
+}
+
+int benchEverything() {
+    std::vector<std::array<BenchmarkStats, 3>> stats(day_constructor_functions.size());
 
     int i = 1;
     for (auto& [day, ctor] : day_constructor_functions) {
@@ -115,9 +139,77 @@ int benchEverything() {
     return static_cast<int>(ExitCodes::OK);
 }
 
+// bench_all spread over worker processes. [rootFolder] coordinate [port] (local_workers) (comma separated days, default all)
+int coordinate(int argc, char** argv) {
+    if (argc < 4) {
+        std::cout << "Require port: [rootFolder] coordinate [port] (local_workers) (days)\n";
+        return static_cast<int>(ExitCodes::NO_INPUT);
+    }
+    int port = std::stoi(argv[3]);
+    int localWorkers = argc > 4 ? std::stoi(argv[4]) : 0;
+
+    std::vector<int> days;
+    if (argc > 5) {
+        std::istringstream list(argv[5]);
+        std::string d;
+        while (std::getline(list, d, ',')) days.push_back(std::stoi(d));
+    } else {
+        for (auto& [day, _] : day_constructor_functions) days.push_back(day);
+    }
+
+    // a few jobs per phase per worker, so a slow host does not hold up the end of the sweep.
+    Distributed::Coordinator coordinator(days, getSampleSize, std::max(1, 2 * localWorkers));
+    if (! coordinator.listen(port)) {
+        return static_cast<int>(ExitCodes::BAD_INPUT);
+    }
+    auto children = Distributed::spawnLocalWorkers(localWorkers, argv[0], argv[1], port);
+    coordinator.serve();
+    Distributed::reapWorkers(children);
+
+    coordinator.report(std::cout);
+    return static_cast<int>(ExitCodes::OK);
+}
+
+// Removes '--threads N' from the arguments, wherever it is. Sizes both the task pool and OpenMP, so strong scaling can be measured.
+// Returns false if the flag is there but malformed.
+bool extractThreadCount(int& argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--threads") continue;
+
+        if (i + 1 >= argc) {
+            std::cout << "--threads requires a thread count\n";
+            return false;
+        }
+
+        std::string_view text = argv[i + 1];
+        int n = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), n);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            std::cout << "--threads expects a number, got '" << text << "'\n";
+            return false;
+        }
+        if (n < 1) {
+            std::cout << "--threads must be at least 1\n";
+            return false;
+        }
+
+        TaskPool::setThreadCount(n);
+        omp_set_num_threads(n);
+
+        std::copy(argv + i + 2, argv + argc, argv + i);
+        argc -= 2;
+        break;
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
+    if (! extractThreadCount(argc, argv)) {
+        return static_cast<int>(ExitCodes::BAD_INPUT);
+    }
+
     if (argc < 3) {
-        std::cout << "Require input: [rootFolder] [solve|bench|bench_all] [dayNumber] (bench_sample_size)\n";
+        std::cout << "Require input: [rootFolder] [solve|bench|bench_all|batch|coordinate|worker] [dayNumber] (bench_sample_size | batch_input_dir (batch_queue_capacity)) (--threads N)\n";
         return static_cast<int>(ExitCodes::NO_INPUT);
     }
 
@@ -125,8 +217,17 @@ int main(int argc, char** argv) {
     std::string mode = argv[2];
 
     if (mode == "bench_all") {
-        std::cout << "bench all call.\n";
+        std::cout << "bench all call. (" << TaskPool::global().threadCount() << " threads)\n";
         return benchEverything();
+    } else if (mode == "coordinate") {
+        return coordinate(argc, argv);
+    } else if (mode == "worker") {
+        if (argc < 5) {
+            std::cout << "Require coordinator: [rootFolder] worker [host] [port]\n";
+            return static_cast<int>(ExitCodes::NO_INPUT);
+        }
+        bool ok = Distributed::runWorker(argv[3], argv[4], day_without_input_functions);
+        return static_cast<int>(ok ? ExitCodes::OK : ExitCodes::BAD_INPUT);
     } else if (argc < 4) {
         std::cout << "Require day number (int)\n";
         return static_cast<int>(ExitCodes::NO_INPUT);
@@ -136,6 +237,27 @@ int main(int argc, char** argv) {
 
     std::cout << mode << " day " << day << "\n";
 
+    // batch mode brings its own inputs, day_NN/dayN.txt need not even exist.
+    if (mode == "batch") {
+        if (argc < 5) {
+            std::cout << "Require a directory of inputs for batch mode\n";
+            return static_cast<int>(ExitCodes::NO_INPUT);
+        }
+        auto factory = day_without_input_functions.find(day);
+        if (factory == day_without_input_functions.end()) {
+            std::cout << "There is no day " << day << "\n";
+            return static_cast<int>(ExitCodes::BAD_INPUT);
+        }
+        size_t queueCapacity = argc > 5 ? std::stoul(argv[5]) : 4;
+        Batch::BatchRunner runner(factory->second, queueCapacity);
+        return static_cast<int>(runner.run(argv[4]) ? ExitCodes::OK : ExitCodes::BAD_INPUT);
+    }
+
+    if (mode != "solve" && mode != "bench") {
+        std::cout << "unknown mode '" << mode << "'\n";
+        return static_cast<int>(ExitCodes::BAD_INPUT);
+    }
+
     // looking up a day that does not exist will cause std::bad_function_call to be thrown,
     // because operator[] creates a new default-initialized value if the key is not found.
     // looking up a day that is not implemented will cause std::logic_error to be thrown,
@@ -144,15 +266,12 @@ int main(int argc, char** argv) {
 
     if (mode == "solve") {
         solver->solve();
-    } else if (mode == "bench") {
+    } else {
         if (argc > 4) {
             solver->benchmark(std::stoi(argv[4]));
         } else {
             solver->benchmark();
         }
-    } else {
-        std::cout << "unknown mode '" << mode << "'\n";
-        return static_cast<int>(ExitCodes::BAD_INPUT);
     }
 
     return static_cast<int>(ExitCodes::OK);
@@ -0,0 +1,523 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef AOC_HAVE_LIBURING
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <liburing.h>
+#endif
+
+#include "Day.hpp"
+#include "BenchStats.hpp"
+
+/**
+ * Batch mode: replay a directory of inputs through one Day solver.
+ *
+ * Three stages, each a coroutine on its own executor, connected by bounded channels:
+ *      read  (io executor, io_uring if built with liburing, otherwise blocking reads on the io thread pool)
+ *      parse (parse executor, 1 thread)
+ *      solve (solve executor, 1 thread, prints the solutions in input order)
+ * So file N+1 is read and parsed while file N is solved. A full channel suspends the producer, an empty one the consumer.
+ *
+ * Every stage records per-item work time and time spent waiting on its input. A solve stage that waits a lot is starved by storage.
+ */
+namespace Batch {
+
+/**
+ * Threads that resume coroutines (or run any other job) in FIFO order.
+ */
+class Executor {
+public:
+    explicit Executor(unsigned threads) {
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+            pool.emplace_back([this](){ loop(); });
+        }
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    ~Executor() {
+        {
+            std::lock_guard lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : pool) t.join();
+    }
+
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard lock(m);
+            jobs.emplace_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+
+    void schedule(std::coroutine_handle<> h) {
+        post([h](){ h.resume(); });
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::vector<std::thread> pool;
+
+    void loop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(m);
+                cv.wait(lock, [this](){ return stopping || ! jobs.empty(); });
+                if (jobs.empty()) return; // only when stopping.
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+/**
+ * Fire-and-forget coroutine. Starts suspended, start() hands it to an executor. The frame destroys itself at the end.
+ * Stages must not let exceptions escape (see BatchRunner::fail), an escaping one terminates.
+ */
+struct Stage {
+    struct promise_type {
+        Stage get_return_object() { return Stage{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    void start(Executor& on) { on.schedule(handle); }
+};
+
+/**
+ * Single producer, single consumer bounded queue with awaitable push and pop.
+ * A suspended side is resumed on the executor it passed in, not on the thread that woke it up.
+ * close() may come from either side: pops drain what is left and then yield nullopt, pushes yield false.
+ */
+template<typename T>
+class Channel {
+public:
+    explicit Channel(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    struct PushAwaiter {
+        Channel& c;
+        Executor& exec;
+        T value;
+        std::coroutine_handle<> handle {};
+        bool accepted = true;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::lock_guard lock(c.m);
+            if (c.closed) {
+                accepted = false;
+                return false;
+            }
+            if (c.items.size() < c.capacity) {
+                c.items.emplace_back(std::move(value));
+                c.wakePopper();
+                return false;
+            }
+            handle = h;
+            c.pusher = this;
+            return true;
+        }
+
+        bool await_resume() const noexcept { return accepted; }
+    };
+
+    struct PopAwaiter {
+        Channel& c;
+        Executor& exec;
+        std::optional<T> result {};
+        std::coroutine_handle<> handle {};
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::lock_guard lock(c.m);
+            if (! c.items.empty()) {
+                result = std::move(c.items.front());
+                c.items.pop_front();
+                c.admitPusher();
+                return false;
+            }
+            if (c.closed) {
+                return false; // result stays nullopt.
+            }
+            handle = h;
+            c.popper = this;
+            return true;
+        }
+
+        std::optional<T> await_resume() { return std::move(result); }
+    };
+
+    PushAwaiter push(T value, Executor& resumeOn) { return PushAwaiter{*this, resumeOn, std::move(value)}; }
+    PopAwaiter pop(Executor& resumeOn) { return PopAwaiter{*this, resumeOn}; }
+
+    void close() {
+        std::lock_guard lock(m);
+        closed = true;
+        if (popper && items.empty()) {
+            auto* p = std::exchange(popper, nullptr);
+            p->exec.schedule(p->handle);
+        }
+        if (pusher) {
+            auto* p = std::exchange(pusher, nullptr);
+            p->accepted = false;
+            p->exec.schedule(p->handle);
+        }
+    }
+
+private:
+    std::mutex m;
+    const size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    PushAwaiter * pusher = nullptr; // suspended because the channel is full.
+    PopAwaiter * popper = nullptr; // suspended because the channel is empty.
+
+    // both called with m held.
+    void wakePopper() {
+        if (! popper) return;
+        auto* p = std::exchange(popper, nullptr);
+        p->result = std::move(items.front());
+        items.pop_front();
+        p->exec.schedule(p->handle);
+    }
+
+    void admitPusher() {
+        if (! pusher) return;
+        auto* p = std::exchange(pusher, nullptr);
+        items.emplace_back(std::move(p->value));
+        p->exec.schedule(p->handle);
+    }
+};
+
+struct FileBlob {
+    std::filesystem::path path;
+    std::string bytes;
+};
+
+struct ParsedInput {
+    std::filesystem::path path;
+    std::unique_ptr<Day> solver;
+};
+
+/**
+ * Reads a whole file into memory as an awaitable.
+ * With liburing: one ring, a completion thread resumes the reader on the io executor.
+ * Without: the read is a blocking read, done by whichever io executor thread resumes the awaiter.
+ */
+class FileReader {
+public:
+#ifdef AOC_HAVE_LIBURING
+    FileReader() {
+        if (io_uring_queue_init(8, &ring, 0) != 0) {
+            throw std::runtime_error("io_uring_queue_init failed");
+        }
+        completions = std::thread([this](){ completionLoop(); });
+    }
+
+    ~FileReader() {
+        // a NOP with null user data tells the completion thread to stop.
+        {
+            std::lock_guard lock(submitMutex);
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+            io_uring_submit(&ring);
+        }
+        completions.join();
+        io_uring_queue_exit(&ring);
+    }
+#endif
+
+    struct ReadAwaiter {
+        FileReader& reader;
+        Executor& exec;
+        std::filesystem::path path;
+        FileBlob result {};
+        std::coroutine_handle<> handle {};
+        int fd = -1;
+        std::string error {};
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            result.path = path;
+#ifdef AOC_HAVE_LIBURING
+            reader.submit(*this);
+#else
+            readOnPool(*this);
+#endif
+        }
+
+        FileBlob await_resume() {
+            if (! error.empty()) throw std::invalid_argument(error);
+            return std::move(result);
+        }
+    };
+
+    ReadAwaiter read(const std::filesystem::path& p, Executor& resumeOn) { return ReadAwaiter{*this, resumeOn, p}; }
+
+    static const char * backend() {
+#ifdef AOC_HAVE_LIBURING
+        return "io_uring";
+#else
+        return "thread pool";
+#endif
+    }
+
+private:
+    // a plain blocking read, on the executor's threads.
+    static void readOnPool(ReadAwaiter& a) {
+        a.exec.post([&a](){
+            std::ifstream in(a.path, std::ios::binary);
+            if (! in) {
+                a.error = "could not read: " + a.path.string();
+            } else {
+                std::ostringstream buf;
+                buf << in.rdbuf();
+                a.result.bytes = std::move(buf).str();
+            }
+            a.handle.resume();
+        });
+    }
+
+#ifdef AOC_HAVE_LIBURING
+    // Linux hands out at most this much per read (MAX_RW_COUNT), and the sqe length is 32 bits anyway.
+    static constexpr uint64_t MAX_SINGLE_READ = 0x7ffff000;
+
+    io_uring ring{};
+    std::mutex submitMutex;
+    std::thread completions;
+
+    void submit(ReadAwaiter& a) {
+        a.fd = ::open(a.path.c_str(), O_RDONLY);
+        struct stat st{};
+        if (a.fd < 0 || ::fstat(a.fd, &st) != 0) {
+            if (a.fd >= 0) ::close(a.fd);
+            a.error = "could not read: " + a.path.string();
+            a.exec.schedule(a.handle);
+            return;
+        }
+        if (static_cast<uint64_t>(st.st_size) > MAX_SINGLE_READ) { // too big for one read, take the slow road.
+            ::close(a.fd);
+            a.fd = -1;
+            readOnPool(a);
+            return;
+        }
+        a.result.bytes.resize(st.st_size);
+
+        std::lock_guard lock(submitMutex);
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_read(sqe, a.fd, a.result.bytes.data(), static_cast<unsigned>(st.st_size), 0);
+        io_uring_sqe_set_data(sqe, &a);
+        io_uring_submit(&ring);
+    }
+
+    void completionLoop() {
+        while (true) {
+            io_uring_cqe* cqe = nullptr;
+            if (io_uring_wait_cqe(&ring, &cqe) != 0) continue;
+            auto* a = static_cast<ReadAwaiter*>(io_uring_cqe_get_data(cqe));
+            int res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+            if (a == nullptr) return;
+
+            ::close(a->fd);
+            if (res < 0) {
+                a->error = "could not read: " + a->path.string();
+            } else {
+                a->result.bytes.resize(res); // short reads only happen if the file shrunk under us. Take what we got.
+            }
+            a->exec.schedule(a->handle);
+        }
+    }
+#endif
+};
+
+/**
+ * Per stage bookkeeping. 'work' is the time per item doing the stage's job, 'starved' the time per item waiting on the previous stage.
+ */
+struct StageStats {
+    const char * name;
+    BenchmarkStats work {std::chrono::microseconds{1}};
+    BenchmarkStats starved {std::chrono::microseconds{1}};
+    uint64_t bytes = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const StageStats& s) {
+    auto busy = s.work.total();
+    auto waited = s.starved.total();
+    double busySeconds = std::chrono::duration<double>(busy).count();
+
+    os << "[" << s.name << "] items: " << s.work.n_samples();
+    if (s.work.n_samples() > 0) {
+        os << ", work mean (median): " << s.work.format(s.work.mean()) << " (" << s.work.format(s.work.median()) << ")";
+        os << ", busy: " << s.work.format(busy) << ", starved: " << s.starved.format(waited);
+        if (busySeconds > 0) {
+            os << ", throughput: " << static_cast<double>(s.work.n_samples()) / busySeconds << " items/s";
+            if (s.bytes > 0) {
+                os << " (" << static_cast<double>(s.bytes) / busySeconds / (1024 * 1024) << " MiB/s)";
+            }
+        }
+    }
+    return os;
+}
+
+class BatchRunner {
+public:
+    using SolverFactory = std::function<std::unique_ptr<Day>()>;
+
+    BatchRunner(SolverFactory factory, size_t queueCapacity, unsigned ioThreads = 2)
+        : factory(std::move(factory)), toParse(queueCapacity), toSolve(queueCapacity), ioExec(ioThreads), parseExec(1), solveExec(1) {}
+
+    // Solves every regular file in 'directory', in name order. Returns false if any stage failed.
+    bool run(const std::filesystem::path& directory) {
+        std::vector<std::filesystem::path> inputs;
+        for (auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.is_regular_file()) inputs.push_back(entry.path());
+        }
+        std::sort(inputs.begin(), inputs.end());
+
+        std::cout << "batch: " << inputs.size() << " inputs, reads via " << FileReader::backend() << "\n";
+
+        std::latch done(3);
+        auto start = std::chrono::steady_clock::now();
+        readStage(inputs, done).start(ioExec);
+        parseStage(done).start(parseExec);
+        solveStage(done).start(solveExec);
+        done.wait();
+        auto wall = std::chrono::steady_clock::now() - start;
+
+        for (auto* s : { &readStats, &parseStats, &solveStats }) {
+            std::cout << *s << "\n";
+        }
+        std::cout << "wall: " << solveStats.work.format(wall) << "\n";
+
+        std::lock_guard lock(errorMutex);
+        if (! error.empty()) {
+            std::cout << "batch failed: " << error << "\n";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    SolverFactory factory;
+    FileReader reader;
+    Channel<FileBlob> toParse;
+    Channel<ParsedInput> toSolve;
+
+    StageStats readStats {"read"};
+    StageStats parseStats {"parse"};
+    StageStats solveStats {"solve"};
+
+    std::mutex errorMutex;
+    std::string error;
+
+    // Declared last: destroyed first, so no executor thread outlives the channels or stats it may touch.
+    Executor ioExec;
+    Executor parseExec;
+    Executor solveExec;
+
+    void fail(const std::string& what) {
+        std::lock_guard lock(errorMutex);
+        if (error.empty()) error = what;
+    }
+
+    static Time since(std::chrono::steady_clock::time_point t) { return std::chrono::steady_clock::now() - t; }
+
+    Stage readStage(std::vector<std::filesystem::path> inputs, std::latch& done) {
+        try {
+            for (auto& p : inputs) {
+                auto t = std::chrono::steady_clock::now();
+                FileBlob blob = co_await reader.read(p, ioExec);
+                readStats.work.measurement(since(t));
+                readStats.starved.measurement(Time{0}); // nothing upstream to wait for.
+                readStats.bytes += blob.bytes.size();
+
+                if (! co_await toParse.push(std::move(blob), ioExec)) break; // downstream gave up.
+            }
+        } catch (const std::exception& e) {
+            fail(std::string("read: ") + e.what());
+        }
+        toParse.close();
+        done.count_down();
+    }
+
+    Stage parseStage(std::latch& done) {
+        try {
+            while (true) {
+                auto t = std::chrono::steady_clock::now();
+                auto blob = co_await toParse.pop(parseExec);
+                if (! blob) break;
+                parseStats.starved.measurement(since(t));
+
+                t = std::chrono::steady_clock::now();
+                ParsedInput parsed { blob->path, factory() };
+                std::istringstream s(std::move(blob->bytes));
+                parsed.solver->parse(s);
+                parseStats.work.measurement(since(t));
+
+                if (! co_await toSolve.push(std::move(parsed), parseExec)) break;
+            }
+        } catch (const std::exception& e) {
+            fail(std::string("parse: ") + e.what());
+        }
+        toParse.close(); // unblocks the reader if we stopped early.
+        toSolve.close();
+        done.count_down();
+    }
+
+    Stage solveStage(std::latch& done) {
+        try {
+            while (true) {
+                auto t = std::chrono::steady_clock::now();
+                auto parsed = co_await toSolve.pop(solveExec);
+                if (! parsed) break;
+                solveStats.starved.measurement(since(t));
+
+                t = std::chrono::steady_clock::now();
+                parsed->solver->solveParsed(parsed->path.filename().string() + " ");
+                solveStats.work.measurement(since(t));
+            }
+        } catch (const std::exception& e) {
+            fail(std::string("solve: ") + e.what());
+        }
+        toSolve.close();
+        done.count_down();
+    }
+};
+
+} // namespace Batch
@@ -8,10 +8,32 @@
 #include <stdexcept>
 #include <cmath>
 #include <iostream>
+#include <random>
+#include <tuple>
 // todo: cannot #include format, need g++ 13 or higher. currently on 11.
 
 using Time = std::chrono::steady_clock::duration;
 
+struct ConfidenceInterval {
+    Time lower;
+    Time estimate;
+    Time upper;
+};
+
+/**
+ * Samples far from the median, in units of the MAD scaled to a standard deviation (1.4826 * MAD).
+ * Mild: beyond 2.7, severe: beyond 4.7. For normal data these are exactly Tukey's 1.5 and 3 IQR fences (what Criterion uses),
+ * but the median and MAD are not dragged along by the outliers they are looking for.
+ */
+struct OutlierCounts {
+    size_t low_severe = 0;
+    size_t low_mild = 0;
+    size_t high_mild = 0;
+    size_t high_severe = 0;
+
+    [[nodiscard]] size_t total() const { return low_severe + low_mild + high_mild + high_severe; }
+};
+
 /**
  * Structure for storing stats of a "benchmark".
  *
@@ -47,6 +69,13 @@ public:
 
     void reserve(int n) { all.reserve(n); }
 
+    // Appends all of other's samples, as if they had been measured here after our own.
+    void merge(const BenchmarkStats& other) {
+        all.insert(all.end(), other.all.begin(), other.all.end());
+    }
+
+    [[nodiscard]] const std::vector<Time>& samples() const { return all; }
+
     [[nodiscard]] Time lowest() const {
         return * std::min_element(all.begin(), all.end());
     }
@@ -57,34 +86,174 @@ public:
 
     // assumes size > 0
     [[nodiscard]] Time mean() const {
-        auto sum = std::accumulate(all.begin(), all.end(), Time{});
-        return sum / all.size();
+        return total() / all.size();
+    }
+
+    [[nodiscard]] Time total() const {
+        return std::accumulate(all.begin(), all.end(), Time{});
     }
 
     // assumes size > 0
     [[nodiscard]] Time median() const {
-        if (all.size() % 2 == 1) {
-            return all[all.size() / 2];
-        } else {
-            return (all[n_samples() / 2] + all[n_samples() / 2 - 1]) / 2;
-        }
+        return median_of_sorted(get_sorted());
     }
 
     [[nodiscard]] Time std_dev() const {
         if (all.size() <= 1) { return Time{0}; } // 0 divided by 0 otherwise, it's a bad time.
 
-        auto x = mean();
-        Time::rep squaredSum = 0;
+        // in floating point: squared nanoseconds of a slow day do not fit in Time::rep.
+        auto x = static_cast<double>(mean().count());
+        double squaredSum = 0;
         for (auto& s : all) {
-            squaredSum += (s - x).count() * (s - x).count();
+            auto d = static_cast<double>(s.count()) - x;
+            squaredSum += d * d;
         }
-        auto result = std::sqrt(squaredSum / (n_samples() - 1));
-        return Time {static_cast<decltype(squaredSum)>(result) };
+        auto result = std::sqrt(squaredSum / static_cast<double>(n_samples() - 1));
+        return Time { static_cast<Time::rep>(result) };
+    }
+
+    // 'amount' of work done per sample, per second of the median sample. (e.g. bytes per second.) assumes size > 0
+    [[nodiscard]] double throughput(double amount) const {
+        return amount / std::chrono::duration<double>(median()).count();
     }
 
-    // assumes 0 < ile < 1
+    // assumes 0 < ile < 1. nth_ile(0.05) is the 5th percentile: 5% of the samples are at or below it.
     [[nodiscard]] Time nth_ile(double ile) const {
-        return get_sorted()[static_cast<int>(n_samples() * ile)]; // NOLINT(cppcoreguidelines-narrowing-conversions) -- if you have 2^53 measurements you have bigger problems.
+        auto index = static_cast<size_t>(static_cast<double>(n_samples()) * ile);
+        return get_sorted()[std::min(index, n_samples() - 1)];
+    }
+
+    // median absolute deviation. assumes size > 0
+    [[nodiscard]] Time mad() const {
+        auto m = median();
+        std::vector<Time> deviations;
+        deviations.reserve(all.size());
+        for (auto& s : all) deviations.push_back(s > m ? s - m : m - s);
+        std::sort(deviations.begin(), deviations.end());
+        return median_of_sorted(deviations);
+    }
+
+    [[nodiscard]] OutlierCounts outliers() const {
+        OutlierCounts counts;
+        if (all.empty()) return counts;
+
+        auto m = static_cast<double>(median().count());
+        auto sigma = 1.4826 * static_cast<double>(mad().count());
+        if (sigma == 0) return counts; // more than half the samples are identical, nothing sensible to say.
+
+        for (auto& s : all) {
+            auto z = (static_cast<double>(s.count()) - m) / sigma;
+            if (z < -4.7) counts.low_severe++;
+            else if (z < -2.7) counts.low_mild++;
+            else if (z > 4.7) counts.high_severe++;
+            else if (z > 2.7) counts.high_mild++;
+        }
+        return counts;
+    }
+
+    enum class Statistic { MEAN, MEDIAN };
+
+    /**
+     * Percentile bootstrap: resample the samples with replacement, take the statistic of every resample,
+     * and the middle 'confidence' part of those is the interval. Seeded, so the same data gives the same interval.
+     */
+    [[nodiscard]] ConfidenceInterval bootstrap_ci(Statistic statistic, double confidence = 0.95, int resamples = 1000) const {
+        auto estimate = statistic == Statistic::MEAN ? mean() : median();
+        if (all.size() <= 1) return { estimate, estimate, estimate };
+
+        std::mt19937_64 rng(0xA0C2023);
+        std::uniform_int_distribution<size_t> pick(0, all.size() - 1);
+        std::vector<Time> resample(all.size());
+        std::vector<Time> statistics;
+        statistics.reserve(resamples);
+        for (int r = 0; r < resamples; ++r) {
+            for (auto& x : resample) x = all[pick(rng)];
+
+            if (statistic == Statistic::MEAN) {
+                statistics.push_back(std::accumulate(resample.begin(), resample.end(), Time{}) / resample.size());
+            } else {
+                auto middle = resample.begin() + static_cast<long>(resample.size() / 2);
+                std::nth_element(resample.begin(), middle, resample.end());
+                statistics.push_back(*middle);
+            }
+        }
+        std::sort(statistics.begin(), statistics.end());
+
+        auto tail = (1.0 - confidence) / 2;
+        auto lo = static_cast<size_t>(tail * resamples);
+        auto hi = std::min(statistics.size() - 1, static_cast<size_t>((1.0 - tail) * resamples));
+        return { statistics[lo], estimate, statistics[hi] };
+    }
+
+    /**
+     * Sarle's bimodality coefficient: (skewness^2 + 1) / (excess kurtosis + 3(n-1)^2 / ((n-2)(n-3))).
+     * 5/9 for a uniform distribution. Above that, suspect two modes, e.g. the CPU switching frequency halfway through.
+     * Computed without far outliers: a handful of preempted samples make any timing distribution look skewed.
+     */
+    [[nodiscard]] double bimodality_coefficient() const {
+        auto v = without_far_outliers();
+        auto n = static_cast<double>(v.size());
+        if (n < 4) return 0;
+
+        auto x = static_cast<double>(std::accumulate(v.begin(), v.end(), Time{}).count()) / n;
+        double m2 = 0, m3 = 0, m4 = 0;
+        for (auto& s : v) {
+            auto d = static_cast<double>(s.count()) - x;
+            m2 += d * d;
+            m3 += d * d * d;
+            m4 += d * d * d * d;
+        }
+        m2 /= n; m3 /= n; m4 /= n;
+        if (m2 == 0) return 0;
+
+        // sample-size corrected skewness and excess kurtosis.
+        auto skew = (m3 / std::pow(m2, 1.5)) * std::sqrt(n * (n - 1)) / (n - 2);
+        auto kurt = ((n + 1) * (m4 / (m2 * m2) - 3) + 6) * (n - 1) / ((n - 2) * (n - 3));
+
+        return (skew * skew + 1) / (kurt + 3 * (n - 1) * (n - 1) / ((n - 2) * (n - 3)));
+    }
+
+    // The coefficient says so, and both modes hold at least 5% of the samples.
+    [[nodiscard]] bool is_bimodal() const {
+        if (bimodality_coefficient() <= 5.0 / 9.0) return false;
+        auto fraction = std::get<2>(modes());
+        return fraction >= 0.05 && fraction <= 0.95;
+    }
+
+    /**
+     * Splits the samples (minus far outliers) in two groups where the within-group variance is smallest (Otsu / 1D 2-means).
+     * Only meaningful if is_bimodal(). Returns the medians of the low and high group, and the fraction of samples in the low group.
+     */
+    [[nodiscard]] std::tuple<Time, Time, double> modes() const {
+        auto v = without_far_outliers(); // sorted
+        if (v.size() < 2) return { median(), median(), 1.0 };
+
+        std::vector<double> prefix(v.size() + 1, 0), prefixSq(v.size() + 1, 0);
+        for (size_t i = 0; i < v.size(); ++i) {
+            auto x = static_cast<double>(v[i].count());
+            prefix[i + 1] = prefix[i] + x;
+            prefixSq[i + 1] = prefixSq[i] + x * x;
+        }
+        // sum of squared deviations of v[a, b) from their mean.
+        auto sse = [&](size_t a, size_t b) {
+            auto n = static_cast<double>(b - a);
+            auto sum = prefix[b] - prefix[a];
+            return (prefixSq[b] - prefixSq[a]) - sum * sum / n;
+        };
+
+        size_t best = 1;
+        double bestCost = sse(0, 1) + sse(1, v.size());
+        for (size_t split = 2; split < v.size(); ++split) {
+            auto cost = sse(0, split) + sse(split, v.size());
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = split;
+            }
+        }
+
+        auto low = std::vector<Time>(v.begin(), v.begin() + static_cast<long>(best));
+        auto high = std::vector<Time>(v.begin() + static_cast<long>(best), v.end());
+        return { median_of_sorted(low), median_of_sorted(high), static_cast<double>(best) / static_cast<double>(v.size()) };
     }
 
 private:
@@ -94,6 +263,27 @@ private:
     std::vector<Time> all; // aligned 'temporally', i.e. earliest first, appended by measure();
     std::vector<Time> sorted; // only created if required by function calls. Transparently maintained. Do not use other than through get_sorted().
 
+    // sorted, like get_sorted(), but without samples beyond Tukey's outer fences (3 IQR past the quartiles).
+    // Quartiles, not the MAD: with two modes the MAD only sees the bigger one, and would cut away the other.
+    [[nodiscard]] std::vector<Time> without_far_outliers() const {
+        auto& v = get_sorted();
+        if (v.empty()) return v;
+
+        auto q1 = nth_ile(0.25);
+        auto q3 = nth_ile(0.75);
+        auto lowFence = q1 - 3 * (q3 - q1);
+        auto highFence = q3 + 3 * (q3 - q1);
+        return { std::lower_bound(v.begin(), v.end(), lowFence), std::upper_bound(v.begin(), v.end(), highFence) };
+    }
+
+    static Time median_of_sorted(const std::vector<Time>& v) {
+        if (v.size() % 2 == 1) {
+            return v[v.size() / 2];
+        } else {
+            return (v[v.size() / 2] + v[v.size() / 2 - 1]) / 2;
+        }
+    }
+
     [[nodiscard]] const std::vector<Time>& get_sorted() const {
         /** Bad To the Bone Riff */
         auto sorted_ptr = const_cast<std::vector<Time>*>(&sorted);
@@ -106,7 +296,7 @@ private:
         return sorted;
     }
 
-    friend int benchEverything();
+public:
     // absolute mess of code, it keeps breaking I hate this.
     [[nodiscard]] std::string format(const Time& value) const {
         if (value.count() == 0) { // 0 will result in infinite loops when upgrading/downgrading displayed time unit. Might as well exit early and just say it's zero.
@@ -164,9 +354,31 @@ inline std::ostream& operator<<(std::ostream& o, const BenchmarkStats& b) {
     << "\tMean (Median): " << b.format(b.mean()) << " (" << b.format(b.median()) << ")\n"
     << "\tStdDev: " << b.format(b.std_dev()) << "\n"
     << "\tlowest / highest: " << b.format(b.lowest()) << " / " << b.format(b.highest()) << "\n"
-    << "\t5/95 %-ile: " << b.format(b.nth_ile(0.05)) << " / " << b.format(b.nth_ile(0.95)) << "\n" // might have mixed up the definition of %-ile, maybe the labels should be swapped. oh well.
-    //<< "\tCI (95% 2-sided)" << "\n" // excessive.
-    << "}";
+    << "\t5/95 %-ile: " << b.format(b.nth_ile(0.05)) << " / " << b.format(b.nth_ile(0.95)) << "\n";
+
+    auto [meanLo, _m, meanHi] = b.bootstrap_ci(BenchmarkStats::Statistic::MEAN);
+    auto [medianLo, _md, medianHi] = b.bootstrap_ci(BenchmarkStats::Statistic::MEDIAN);
+    o
+    << "\tMean CI (95%): [" << b.format(meanLo) << ", " << b.format(meanHi) << "]\n"
+    << "\tMedian CI (95%): [" << b.format(medianLo) << ", " << b.format(medianHi) << "]\n"
+    << "\tMAD: " << b.format(b.mad()) << "\n";
+
+    auto out = b.outliers();
+    if (out.total() > 0) {
+        o << "\tOutliers: " << out.total() << " / " << b.n_samples()
+        << " (" << 100.0 * static_cast<double>(out.total()) / static_cast<double>(b.n_samples()) << "%): "
+        << out.low_severe << " low severe, " << out.low_mild << " low mild, "
+        << out.high_mild << " high mild, " << out.high_severe << " high severe\n";
+    }
+
+    if (b.is_bimodal()) {
+        auto [low, high, fraction] = b.modes();
+        o << "\tWARNING: bimodal (coefficient " << b.bimodality_coefficient() << "). "
+        << 100.0 * fraction << "% around " << b.format(low) << ", the rest around " << b.format(high)
+        << ". Frequency scaling or a noisy neighbour?\n";
+    }
+
+    o << "}";
 
     return o;
 }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Reading puzzle text in constant expressions.
+ * std::istream can not be used at compile time, so the compile-time solvers (AOC_EMBED_INPUTS) walk a std::string_view with these.
+ * They work just as well at runtime, which is how the answers can be checked against the regular solvers.
+ */
+namespace ConstexprInput {
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Hands out one line at a time, without the '\n' (or '\r\n'). The last line does not need to end in a newline.
+struct Lines {
+    std::string_view rest;
+
+    constexpr bool next(std::string_view& line) {
+        if (rest.empty()) return false;
+
+        auto newline = rest.find('\n');
+        if (newline == std::string_view::npos) {
+            line = rest;
+            rest = {};
+        } else {
+            line = rest.substr(0, newline);
+            rest.remove_prefix(newline + 1);
+        }
+
+        if (! line.empty() && line.back() == '\r') line.remove_suffix(1);
+        return true;
+    }
+};
+
+// Skips anything that is not part of a number, then reads the (optionally negative) number. False when there are no more numbers.
+struct Numbers {
+    std::string_view s;
+    size_t pos = 0;
+
+    constexpr bool next(int64_t& out) {
+        while (pos < s.size() && ! isDigit(s[pos]) && ! (s[pos] == '-' && pos + 1 < s.size() && isDigit(s[pos + 1]))) {
+            ++pos;
+        }
+        if (pos >= s.size()) return false;
+
+        bool negative = s[pos] == '-';
+        if (negative) ++pos;
+
+        int64_t n = 0;
+        while (pos < s.size() && isDigit(s[pos])) {
+            n = n * 10 + (s[pos] - '0');
+            ++pos;
+        }
+
+        out = negative ? -n : n;
+        return true;
+    }
+};
+
+} // namespace
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * What the machine we run on can do. Vectorised solvers are compiled for AVX2 (or AVX-512) with target attributes and picked at
+ * runtime, the rest of the build stays plain x86-64.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AOC_X86 true
+#else
+#define AOC_X86 false
+#endif
+
+namespace Cpu {
+
+inline bool haveAvx2() {
+#if AOC_X86 == true
+    static const bool have = __builtin_cpu_supports("avx2");
+    return have;
+#else
+    return false;
+#endif
+}
+
+inline bool haveAvx512() { // just the foundation, that is all the 64 bit lane compares and min/max need.
+#if AOC_X86 == true
+    static const bool have = __builtin_cpu_supports("avx512f");
+    return have;
+#else
+    return false;
+#endif
+}
+
+} // namespace
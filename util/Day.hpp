@@ -20,7 +20,12 @@ class Day {
 public:
     Day() = delete;
     virtual ~Day() = default;
-    explicit Day(int number) : Day((number < 10 ? "day_0" : "day_") + std::to_string(number) + "/day" + std::to_string(number) + ".txt") {}
+    explicit Day(int number) : Day(inputFileName(number)) {}
+
+    // For solvers that are handed their input some other way (batch mode, distributed workers). Nothing is opened,
+    // so solve() and benchmark() have nothing to read: feed parse() directly.
+    struct WithoutInput {};
+    explicit Day(WithoutInput) {}
 
     explicit Day(const std::string& inputFilePath) {
         auto p = std::filesystem::path(inputFilePath).make_preferred();
@@ -32,9 +37,12 @@ public:
 
     virtual void v1() const = 0;
     virtual void v2() const = 0;
-    virtual void parse(std::ifstream& text) = 0;
+    virtual void parse(std::istream& text) = 0;
     virtual void parseBenchReset() = 0;
 
+    // Days that stream over their whole input can return its size here, and bench also prints the throughput of the solvers.
+    [[nodiscard]] virtual size_t throughputBytes() const { return 0; }
+
     template<typename T> void reportSolution(const T& s) const {
         solution_printer = [s](const char * prefix) {
             std::cout << prefix << s << "\n";
@@ -49,6 +57,14 @@ public:
         solution_printer("v2: ");
     }
 
+    // Like solve(), but for data that was already fed through parse() by someone else. (the batch runner parses from memory.)
+    void solveParsed(const std::string& prefix) const {
+        v1();
+        solution_printer((prefix + "v1: ").c_str());
+        v2();
+        solution_printer((prefix + "v2: ").c_str());
+    }
+
     using StatTriplet = std::array<BenchmarkStats, 3>; // A surprise tool that will help us later.
 
     void benchmark(int sampleCount = 10'000, double reportEveryPct = 0.05) {
@@ -92,6 +108,9 @@ public:
             std::cout << "parse: " << parse_stats << "\n";
             std::cout << "v1: " << v1_stats << "\n";
             std::cout << "v2: " << v2_stats << "\n";
+            if (auto bytes = throughputBytes(); bytes > 0) {
+                std::cout << "throughput (median) v1: " << v1_stats.throughput(bytes) / 1e9 << " GB/s, v2: " << v2_stats.throughput(bytes) / 1e9 << " GB/s\n";
+            }
         }
 
         outStats[0] = std::move(parse_stats);
@@ -99,13 +118,56 @@ public:
         outStats[2] = std::move(v2_stats);
     }
 
+    static constexpr std::array<const char *, 3> PHASE_NAMES { "parse", "v1", "v2" }; // indices match StatTriplet.
+
+    // Benchmarks only one phase (index into PHASE_NAMES). Used when phases are farmed out to other processes, see Distributed.hpp.
+    // Phases may be requested in any order, so this always starts from unparsed input.
+    void benchmarkPhase(int phase, int sampleCount, BenchmarkStats& out) {
+        benchmarkPhase(phase, sampleCount, out, text);
+    }
+
+    // Same, parsing from 'input' instead of the solver's own input file. 'input' has to be seekable.
+    void benchmarkPhase(int phase, int sampleCount, BenchmarkStats& out, std::istream& input) {
+        auto resetSolver = [this](){ solution_printer = {}; };
+        auto resetParser = [this, &input](){
+            input.clear();
+            input.seekg(0);
+            parseBenchReset();
+        };
+
+        resetParser();
+        switch (phase) {
+            default: throw std::invalid_argument("unknown phase " + std::to_string(phase));
+            case 0:
+                bench(sampleCount, 1.0, [this, &input](){ parse(input); }, out, PHASE_NAMES[0], resetParser);
+                break;
+            case 1:
+                parse(input);
+                bench(sampleCount, 1.0, [this](){ v1(); }, out, PHASE_NAMES[1], resetSolver);
+                break;
+            case 2:
+                parse(input);
+                bench(sampleCount, 1.0, [this](){ v2(); }, out, PHASE_NAMES[2], resetSolver);
+                break;
+        }
+    }
+
     static void setRoot(const std::string& r) {
         Day::root = r;
     }
 
+    // Where Day(number) reads its input from.
+    static std::filesystem::path inputPath(int number) {
+        return root / std::filesystem::path(inputFileName(number)).make_preferred();
+    }
+
 private:
     std::ifstream text;
 
+    static std::string inputFileName(int number) {
+        return (number < 10 ? "day_0" : "day_") + std::to_string(number) + "/day" + std::to_string(number) + ".txt";
+    }
+
     mutable PrinterCallback solution_printer;
 
     static std::filesystem::path root;
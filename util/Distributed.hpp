@@ -0,0 +1,422 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Day.hpp"
+#include "BenchStats.hpp"
+
+/**
+ * Distributed bench_all: one coordinator, N worker processes of main, talking over TCP. (loopback, or across hosts)
+ *
+ *      main [root] coordinate [port] (local_workers) (days)
+ *      main [root] worker [host] [port]
+ *
+ * The coordinator cuts every day/phase into jobs of some samples each and hands them to whichever worker is idle.
+ * Workers send back their raw samples, the coordinator merges them per day/phase into one BenchmarkStats.
+ *
+ * Hosts are not equally fast. Everyone runs the same calibration micro-benchmark first,
+ * and worker samples are scaled by (coordinator calibration / worker calibration), i.e. expressed in coordinator-host time.
+ * Calibration is exclusive: the coordinator calibrates before any worker is started, and then asks one worker at a time,
+ * while no jobs are running. Otherwise workers sharing cores measure each other, and their samples get scaled down.
+ *
+ * The protocol is one line of text per message:
+ *      worker -> coordinator   HELLO <hostname>
+ *      coordinator -> worker   CALIBRATE   |   JOB <day> <phase> <samples>     |   DONE
+ *      worker -> coordinator   CALIBRATION <ns>   |   RESULT <day> <phase> <n> <ns> <ns> ...   |   ERROR <day> <phase> <message>
+ */
+namespace Distributed {
+
+using SolverFactory = std::function<std::unique_ptr<Day>()>;
+using DayRegistry = std::map<int, SolverFactory>; // the worker's solvers are made Day::WithoutInput, it opens only the inputs of its jobs.
+
+/**
+ * Fixed CPU-bound workload: sorting the same pseudo random data. The median of a few runs, so a hiccup does not skew it.
+ */
+inline Time calibrate() {
+    BenchmarkStats s;
+    std::vector<uint32_t> data(1 << 16);
+    for (int run = 0; run < 21; ++run) {
+        uint32_t x = 12345;
+        for (auto& v : data) {
+            x = x * 1664525u + 1013904223u;
+            v = x;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::sort(data.begin(), data.end());
+        s.measurement(std::chrono::steady_clock::now() - start);
+    }
+    return s.nth_ile(0.5);
+}
+
+/**
+ * Line based messages over a socket. Owns the file descriptor.
+ */
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+    ~Connection() { if (fd >= 0) ::close(fd); }
+
+    [[nodiscard]] int handle() const { return fd; }
+
+    void send(const std::string& line) const {
+        std::string msg = line + "\n";
+        size_t sent = 0;
+        while (sent < msg.size()) {
+            auto n = ::send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) throw std::runtime_error("connection lost while sending");
+            sent += n;
+        }
+    }
+
+    // Reads what is available (blocks if nothing is). Returns false when the other side is gone.
+    bool receive() {
+        char buf[65536];
+        auto n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        pending.append(buf, n);
+        return true;
+    }
+
+    // Next complete line, if one arrived.
+    std::optional<std::string> nextLine() {
+        auto newline = pending.find('\n');
+        if (newline == std::string::npos) return std::nullopt;
+        std::string line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        return line;
+    }
+
+    // Blocks until a complete line arrived. nullopt when the other side is gone.
+    std::optional<std::string> readLine() {
+        while (true) {
+            if (auto line = nextLine()) return line;
+            if (! receive()) return std::nullopt;
+        }
+    }
+
+private:
+    int fd;
+    std::string pending;
+};
+
+struct Job {
+    int day;
+    int phase;
+    int samples;
+};
+
+/**
+ * Runs jobs for a coordinator until it says DONE. Returns false if the coordinator could not be reached.
+ */
+inline bool runWorker(const std::string& host, const std::string& port, const DayRegistry& days) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+        std::cout << "worker: cannot resolve " << host << ":" << port << "\n";
+        return false;
+    }
+
+    int fd = -1;
+    for (auto* a = found; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(found);
+    if (fd < 0) {
+        std::cout << "worker: cannot connect to " << host << ":" << port << "\n";
+        return false;
+    }
+
+    Connection c(fd);
+    char hostname[256] = "unknown";
+    ::gethostname(hostname, sizeof(hostname) - 1);
+    c.send("HELLO " + std::string(hostname));
+
+    while (auto line = c.readLine()) {
+        std::istringstream s(*line);
+        std::string kind;
+        s >> kind;
+        if (kind == "DONE") return true;
+        if (kind == "CALIBRATE") {
+            c.send("CALIBRATION " + std::to_string(std::chrono::nanoseconds(calibrate()).count()));
+            continue;
+        }
+        if (kind != "JOB") throw std::logic_error("worker: unexpected message " + *line);
+
+        Job job{};
+        s >> job.day >> job.phase >> job.samples;
+        std::cout << "worker: day " << job.day << " " << Day::PHASE_NAMES.at(job.phase) << " (" << job.samples << "x)\n";
+
+        std::ostringstream reply;
+        try {
+            std::ifstream input(Day::inputPath(job.day));
+            if (! input) throw std::invalid_argument("could not read: " + Day::inputPath(job.day).string());
+            BenchmarkStats stats;
+            days.at(job.day)()->benchmarkPhase(job.phase, job.samples, stats, input);
+            reply << "RESULT " << job.day << " " << job.phase << " " << stats.n_samples();
+            for (auto t : stats.samples()) {
+                reply << " " << std::chrono::nanoseconds(t).count();
+            }
+        } catch (const std::exception& e) {
+            std::string what = e.what();
+            std::replace(what.begin(), what.end(), '\n', ' ');
+            reply.str("");
+            reply << "ERROR " << job.day << " " << job.phase << " " << what;
+        }
+        c.send(reply.str());
+    }
+
+    return true; // coordinator went away, nothing left to do.
+}
+
+class Coordinator {
+public:
+    /**
+     * 'sampleSize' gives the bench_all sample count per day. Each day/phase is cut into about 'jobsPerPhase' jobs.
+     */
+    Coordinator(std::vector<int> days, const std::function<int(int)>& sampleSize, int jobsPerPhase) {
+        for (int day : days) {
+            int total = sampleSize(day);
+            int chunks = std::clamp(jobsPerPhase, 1, total);
+            for (int phase = 0; phase < 3; ++phase) {
+                for (int i = 0; i < chunks; ++i) {
+                    // spread the remainder over the first jobs.
+                    todo.push_back({ day, phase, total / chunks + (i < total % chunks ? 1 : 0) });
+                }
+                stats[{day, phase}] = BenchmarkStats(phase == 0 ? Time{std::chrono::nanoseconds{1}} : Time{std::chrono::milliseconds{1}});
+            }
+        }
+        reference = calibrate();
+    }
+
+    // Opens the port. Do this before starting local workers, or they have nothing to connect to.
+    bool listen(int port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 64) != 0) {
+            std::cout << "coordinator: cannot listen on port " << port << ": " << std::strerror(errno) << "\n";
+            ::close(fd);
+            return false;
+        }
+        listener = std::make_unique<Connection>(fd);
+        std::cout << "coordinator: " << todo.size() << " jobs, listening on port " << port << ", calibration " << format(reference) << "\n";
+        return true;
+    }
+
+    // Serves workers until every job is done, then dismisses them.
+    void serve() {
+        int listenFd = listener->handle();
+        while (! todo.empty() || std::any_of(workers.begin(), workers.end(), [](auto& w){ return w->job.has_value(); })) {
+            std::vector<pollfd> fds { { listenFd, POLLIN, 0 } };
+            for (auto& w : workers) fds.push_back({ w->connection.handle(), POLLIN, 0 });
+
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("poll failed");
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd = ::accept(listenFd, nullptr, nullptr);
+                if (fd >= 0) workers.emplace_back(std::make_unique<Worker>(fd));
+            }
+
+            // back to front, so disconnected workers can be erased while iterating. fds[i] is workers[i - 1], from before the accept.
+            for (size_t i = fds.size() - 1; i > 0; --i) {
+                auto& w = *workers[i - 1];
+                if (! (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+                bool alive = w.connection.receive();
+                while (auto line = w.connection.nextLine()) {
+                    handle(w, *line);
+                }
+
+                if (! alive) {
+                    if (w.job) {
+                        std::cout << "coordinator: lost " << w.name << ", re-queueing its job\n";
+                        todo.push_front(*w.job);
+                    }
+                    workers.erase(workers.begin() + static_cast<long>(i - 1));
+                }
+            }
+
+            dispatch();
+        }
+
+        // workers that connected too late still wait for an answer. Those that connect after the close are refused, and give up.
+        while (true) {
+            pollfd pending { listenFd, POLLIN, 0 };
+            if (::poll(&pending, 1, 0) <= 0 || ! (pending.revents & POLLIN)) break;
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) break;
+            workers.emplace_back(std::make_unique<Worker>(fd));
+        }
+        listener.reset();
+
+        for (auto& w : workers) {
+            try {
+                w->connection.send("DONE");
+            } catch (const std::runtime_error&) {
+                // already gone.
+            }
+        }
+    }
+
+    void report(std::ostream& os) const {
+        os << "workers (samples normalised to coordinator calibration " << format(reference) << "):\n";
+        for (auto& [name, info] : seen) {
+            os << "\t" << name << ": calibration factor " << info.first << ", jobs " << info.second << "\n";
+        }
+        for (auto& [key, s] : stats) {
+            auto [day, phase] = key;
+            os << "Day " << day << " " << Day::PHASE_NAMES[phase] << " mean (median): ";
+            if (s.n_samples() == 0) {
+                os << "failed\n";
+                continue;
+            }
+            os << s.format(s.mean()) << " (" << s.format(s.median()) << "). Sample Size: " << s.n_samples() << "\n";
+        }
+    }
+
+    [[nodiscard]] const std::map<std::pair<int, int>, BenchmarkStats>& results() const { return stats; }
+
+private:
+    struct Worker {
+        explicit Worker(int fd) : connection(fd) {}
+        Connection connection;
+        std::string name = "?";
+        double factor = 1.0;
+        bool greeted = false; // said HELLO
+        bool calibrating = false;
+        bool calibrated = false;
+        std::optional<Job> job;
+    };
+
+    std::unique_ptr<Connection> listener;
+    std::deque<Job> todo;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::map<std::pair<int, int>, BenchmarkStats> stats; // (day, phase)
+    std::map<std::string, std::pair<double, int>> seen; // worker name -> (factor, jobs done)
+    Time reference{};
+
+    static std::string format(Time t) { return BenchmarkStats(std::chrono::microseconds{1}).format(t); }
+
+    void assign(Worker& w) {
+        if (todo.empty()) return;
+        w.job = todo.front();
+        todo.pop_front();
+        w.connection.send("JOB " + std::to_string(w.job->day) + " " + std::to_string(w.job->phase) + " " + std::to_string(w.job->samples));
+    }
+
+    // A worker waiting for calibration holds back new jobs until the running ones are done, then calibrates alone.
+    void dispatch() {
+        auto waiting = std::find_if(workers.begin(), workers.end(), [](auto& w){ return w->greeted && ! w->calibrated; });
+        if (waiting != workers.end()) {
+            bool quiet = std::none_of(workers.begin(), workers.end(), [](auto& w){ return w->calibrating || w->job.has_value(); });
+            if (quiet && ! todo.empty()) {
+                (*waiting)->calibrating = true;
+                (*waiting)->connection.send("CALIBRATE");
+            }
+            return;
+        }
+
+        for (auto& w : workers) {
+            if (w->calibrated && ! w->job) assign(*w);
+        }
+    }
+
+    void handle(Worker& w, const std::string& line) {
+        std::istringstream s(line);
+        std::string kind;
+        s >> kind;
+
+        if (kind == "HELLO") {
+            std::string host;
+            s >> host;
+            w.name = host + "#" + std::to_string(w.connection.handle());
+            w.greeted = true;
+        } else if (kind == "CALIBRATION") {
+            int64_t calibrationNs;
+            s >> calibrationNs;
+            w.factor = static_cast<double>(std::chrono::nanoseconds(reference).count()) / static_cast<double>(std::max<int64_t>(1, calibrationNs));
+            w.calibrating = false;
+            w.calibrated = true;
+            seen[w.name] = { w.factor, 0 };
+        } else if (kind == "RESULT") {
+            int day, phase;
+            size_t n;
+            s >> day >> phase >> n;
+            BenchmarkStats partial;
+            partial.reserve(static_cast<int>(n));
+            for (size_t i = 0; i < n; ++i) {
+                int64_t ns;
+                s >> ns;
+                partial.measurement(std::chrono::duration_cast<Time>(std::chrono::nanoseconds(std::llround(static_cast<double>(ns) * w.factor))));
+            }
+            stats.at({day, phase}).merge(partial);
+            seen[w.name].second++;
+            w.job.reset();
+        } else if (kind == "ERROR") {
+            std::cout << "coordinator: " << w.name << " failed a job: " << line << "\n"; // not re-queued, it would fail again.
+            w.job.reset();
+        } else {
+            throw std::logic_error("coordinator: unexpected message " + line);
+        }
+    }
+};
+
+/**
+ * Starts 'count' workers as child processes of this executable, pointed at localhost.
+ */
+inline std::vector<pid_t> spawnLocalWorkers(int count, const char * self, const std::string& root, int port) {
+    std::vector<pid_t> children;
+    auto portString = std::to_string(port);
+    for (int i = 0; i < count; ++i) {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::execl(self, self, root.c_str(), "worker", "127.0.0.1", portString.c_str(), static_cast<char*>(nullptr));
+            std::perror("execl");
+            ::_exit(127);
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    return children;
+}
+
+inline void reapWorkers(const std::vector<pid_t>& children) {
+    for (auto pid : children) {
+        int status;
+        ::waitpid(pid, &status, 0);
+    }
+}
+
+} // namespace
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Small work-stealing task scheduler, for the workloads that do not fit an OpenMP static loop.
+ * (recursive, irregular: a branch of a search may be 1 node or 10.000 nodes, nobody knows ahead of time.)
+ *
+ * Every worker thread owns a deque. Tasks spawned on a worker go to the back of its own deque,
+ * and the worker pops from the back (LIFO, cache-warm). Idle workers steal from the front of other deques (FIFO, the big chunks).
+ * Threads that are not workers (e.g. main) share queue 0, and help execute tasks while they wait on a TaskGroup.
+ *
+ * The deques are plain mutex-guarded std::deque. Not lock-free, but the tasks we give it are far bigger than a lock.
+ *
+ * With a thread count of 1 there are no worker threads at all. Everything is run by whoever waits, i.e. serially.
+ */
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit TaskPool(unsigned threads) : nThreads(std::max(1u, threads)) {
+        for (unsigned i = 0; i < nThreads; ++i) {
+            queues.emplace_back(std::make_unique<WorkQueue>());
+        }
+        // the thread constructing this pool (and any other outside thread) uses queue 0, so only n-1 workers are made.
+        for (unsigned i = 1; i < nThreads; ++i) {
+            workers.emplace_back([this, i](){ workerLoop(i); });
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping = true;
+        }
+        sleepCv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    [[nodiscard]] unsigned threadCount() const { return nThreads; }
+
+    void submit(Task t) {
+        auto& q = *queues[ownQueueIndex()];
+        {
+            std::lock_guard lock(q.m);
+            q.tasks.emplace_back(std::move(t));
+        }
+        {
+            std::lock_guard lock(sleepMutex);
+            ++queued;
+        }
+        sleepCv.notify_one();
+    }
+
+    // Runs at most 1 task. Own queue first (back), then steals (front) from the others. Returns whether a task was run.
+    bool tryRunOne() {
+        unsigned self = ownQueueIndex();
+        Task t;
+        if (! popBack(*queues[self], t)) {
+            bool stolen = false;
+            for (unsigned i = 1; i < nThreads && ! stolen; ++i) {
+                stolen = popFront(*queues[(self + i) % nThreads], t);
+            }
+            if (! stolen) return false;
+        }
+
+        --queued;
+        t();
+        return true;
+    }
+
+    // The pool used by the days. Its size is set once by the harness (--threads), before anyone calls global().
+    static TaskPool& global() {
+        auto& p = globalStorage();
+        if (! p) {
+            p = std::make_unique<TaskPool>(defaultThreadCount());
+        }
+        return *p;
+    }
+
+    static void setThreadCount(unsigned n) {
+        defaultThreadCount() = std::max(1u, n);
+        globalStorage().reset(); // re-created lazily with the new size.
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    const unsigned nThreads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int64_t> queued = 0;
+    bool stopping = false; // guarded by sleepMutex.
+
+    // which pool the current thread works for, and on which queue. Outside threads are 'nullptr, 0'.
+    static inline thread_local const TaskPool * currentPool = nullptr;
+    static inline thread_local unsigned currentIndex = 0;
+
+    [[nodiscard]] unsigned ownQueueIndex() const {
+        return currentPool == this ? currentIndex : 0;
+    }
+
+    static bool popBack(WorkQueue& q, Task& out) {
+        std::lock_guard lock(q.m);
+        if (q.tasks.empty()) return false;
+        out = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    static bool popFront(WorkQueue& q, Task& out) {
+        std::lock_guard lock(q.m);
+        if (q.tasks.empty()) return false;
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+
+    void workerLoop(unsigned index) {
+        currentPool = this;
+        currentIndex = index;
+
+        while (true) {
+            if (tryRunOne()) continue;
+
+            std::unique_lock lock(sleepMutex);
+            sleepCv.wait(lock, [this](){ return stopping || queued > 0; });
+            if (stopping) return;
+        }
+    }
+
+    static unsigned& defaultThreadCount() {
+        static unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        return n;
+    }
+
+    static std::unique_ptr<TaskPool>& globalStorage() {
+        static std::unique_ptr<TaskPool> p;
+        return p;
+    }
+};
+
+/**
+ * Fork/join handle. run() forks, wait() joins.
+ * The waiting thread does not sleep, it executes tasks from the pool until everything it forked (transitively) is done.
+ * Tasks may call run() on the group they are part of.
+ *
+ * The first exception thrown by any task is rethrown from wait().
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool& pool = TaskPool::global()) : pool(pool) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        drain(); // never leave tasks running that reference this object. Errors are lost here, call wait() to see them.
+    }
+
+    template<typename F>
+    void run(F&& f) {
+        ++outstanding;
+        pool.submit([this, task = std::forward<F>(f)]() mutable {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (! error) error = std::current_exception();
+            }
+            --outstanding;
+        });
+    }
+
+    void wait() {
+        drain();
+        if (error) {
+            auto e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    TaskPool& pool;
+    std::atomic<int64_t> outstanding = 0;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void drain() {
+        while (outstanding > 0) {
+            if (! pool.tryRunOne()) {
+                std::this_thread::yield(); // someone else is running our last task(s).
+            }
+        }
+    }
+};
+
+// Default grain: about 8 chunks per thread, enough to smooth out uneven items without drowning in tasks.
+inline int64_t defaultGrain(int64_t n, const TaskPool& pool = TaskPool::global()) {
+    return std::max<int64_t>(1, n / (8 * static_cast<int64_t>(pool.threadCount())));
+}
+
+// Calls f(i) for every i in [begin, end). The range is split in halves recursively until it is at most 'grain' long.
+template<typename F>
+void parallelFor(int64_t begin, int64_t end, F&& f, int64_t grain = 0, TaskPool& pool = TaskPool::global()) {
+    if (end <= begin) return;
+    if (grain <= 0) grain = defaultGrain(end - begin, pool);
+
+    TaskGroup group(pool);
+    std::function<void(int64_t, int64_t)> split = [&](int64_t b, int64_t e) {
+        while (e - b > grain) {
+            int64_t mid = b + (e - b) / 2;
+            group.run([&split, mid, e](){ split(mid, e); });
+            e = mid;
+        }
+        for (int64_t i = b; i < e; ++i) f(i);
+    };
+
+    split(begin, end);
+    group.wait();
+}
+
+// Fork/join reduction: reduce(map(begin), ..., map(end - 1)) starting from 'identity'. 'reduce' should be associative.
+template<typename T, typename Map, typename Reduce>
+T parallelReduce(int64_t begin, int64_t end, T identity, const Map& map, const Reduce& reduce, int64_t grain = 0, TaskPool& pool = TaskPool::global()) {
+    if (grain <= 0) grain = defaultGrain(end - begin, pool);
+
+    if (end - begin <= grain) {
+        T acc = identity;
+        for (int64_t i = begin; i < end; ++i) acc = reduce(acc, map(i));
+        return acc;
+    }
+
+    int64_t mid = begin + (end - begin) / 2;
+    T right = identity;
+    TaskGroup group(pool);
+    group.run([&](){ right = parallelReduce(mid, end, identity, map, reduce, grain, pool); });
+    T left = parallelReduce(begin, mid, identity, map, reduce, grain, pool);
+    group.wait();
+
+    return reduce(left, right);
+}
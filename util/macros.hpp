@@ -2,5 +2,6 @@
 
 #define CONCATENATE(x, y) x##y
 #define CLASS_DEF(D) class CONCATENATE(Day, D) : public Day
-#define DEFAULT_CTOR_DEF(D) CONCATENATE(Day, D) () : Day(D) {}
+#define DEFAULT_CTOR_DEF(D) CONCATENATE(Day, D) () : Day(D) {} \
+    explicit CONCATENATE(Day, D) (Day::WithoutInput w) : Day(w) {}
 #define NAMESPACE_DEF(D) namespace CONCATENATE(Day, D)
\ No newline at end of file